@@ -0,0 +1,388 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <string>
+#include "ConfigOptimizer.hpp"
+
+//Monte Carlo check of bucket geometries, instead of the normal approximations in the other programs here.
+//Only keeps the mini bucket index of every key, but otherwise does what the filter does: frontyard buckets keep their keys with the smallest mini bucket indices, the rest go to the least full of the two (or with more backyard choices, three or four) backyard buckets BackyardQRContainer maps the frontyard bucket to, and deleting from a frontyard bucket brings its smallest overflowed key back.
+//Build with g++ -std=c++20 -O3 -march=native -I../include GeometrySimulator.cpp -pthread
+//Usage: GeometrySimulator [log2 of the number of frontyard buckets] [trials] [mini buckets, frontyard capacity, backyard capacity, ratio, frontyard bucket bytes, backyard bucket bytes [backyard choices]]
+//Without a geometry it goes through the shipped ones.
+
+using namespace std;
+using namespace PQF;
+
+struct Geometry {
+    string name;
+    size_t numMiniBuckets;
+    size_t frontyardCapacity;
+    size_t backyardCapacity;
+    size_t ratio;
+    size_t frontyardBucketSize;
+    size_t backyardBucketSize;
+    size_t backyardChoices = 2;
+};
+
+//Loads (as a fraction of the N the filter would be constructed with) at which the backyard probe rates get measured
+constexpr array<double, 5> Checkpoints{0.5, 0.75, 0.85, 0.9, 0.95};
+constexpr double ChurnLoad = 0.85;
+constexpr size_t ChurnRounds = 4; //Each live key gets replaced this many times on average
+
+constexpr size_t MaxBackyardChoices = 4;
+using BackyardChoices = array<size_t, MaxBackyardChoices>;
+
+//All four choices, of which the simulation uses the first backyardChoices
+template<size_t Ratio>
+vector<BackyardChoices> getBackyardChoices(size_t numFrontyardBuckets, size_t numBackyardBuckets, size_t R) {
+    using BackyardQRType = BackyardQRContainer<1, 8, Ratio, MaxBackyardChoices>;
+    vector<BackyardChoices> choices(numFrontyardBuckets);
+    for(size_t i{0}; i < numFrontyardBuckets; i++) {
+        FrontyardQRContainer<1> frontyardQR(i, 0);
+#ifdef CUCKOO_HASH
+        array<BackyardQRType, MaxBackyardChoices> qrs{BackyardQRType(frontyardQR, 0, R, numBackyardBuckets), BackyardQRType(frontyardQR, 1, R, numBackyardBuckets)};
+#else
+        array<BackyardQRType, MaxBackyardChoices> qrs{BackyardQRType(frontyardQR, 0, R), BackyardQRType(frontyardQR, 1, R)};
+#endif
+        for(size_t k{0}; k < MaxBackyardChoices; k++) {
+            if(k >= 2) {
+                qrs[k] = qrs[k-2];
+                qrs[k].moveToUpperHalf(numBackyardBuckets);
+            }
+            choices[i][k] = qrs[k].bucketIndex;
+        }
+    }
+    return choices;
+}
+
+//The ratio is a template parameter of BackyardQRContainer, so walk the supported ones until it matches
+template<size_t Ratio = ConfigOptimizerDetail::MinFrontyardToBackyardRatio>
+vector<BackyardChoices> getBackyardChoicesForRatio(size_t ratio, size_t numFrontyardBuckets, size_t numBackyardBuckets, size_t R) {
+    if(ratio == Ratio) {
+        return getBackyardChoices<Ratio>(numFrontyardBuckets, numBackyardBuckets, R);
+    }
+    if constexpr (Ratio < ConfigOptimizerDetail::MaxFrontyardToBackyardRatio) {
+        return getBackyardChoicesForRatio<Ratio + 1>(ratio, numFrontyardBuckets, numBackyardBuckets, R);
+    }
+    else {
+        throw invalid_argument("The frontyard to backyard ratio has to be between " + to_string(ConfigOptimizerDetail::MinFrontyardToBackyardRatio) + " and " + to_string(ConfigOptimizerDetail::MaxFrontyardToBackyardRatio));
+    }
+}
+
+class GeometrySimulation {
+    struct OverflowedKey {
+        uint8_t miniBucketIndex;
+        uint8_t choice; //Which of the backyard buckets it is in
+    };
+
+    Geometry g;
+    size_t numBackyardBuckets;
+    vector<vector<uint8_t>> frontyard; //Sorted mini bucket indices of the keys each frontyard bucket holds
+    vector<vector<OverflowedKey>> overflowed; //Keys of each frontyard bucket that are in the backyard
+    vector<BackyardChoices> backyardChoices;
+    vector<size_t> backyardFill;
+    vector<pair<uint32_t, uint8_t>> liveKeys;
+    mt19937_64 generator;
+
+    size_t backyardBucket(size_t frontyardBucket, uint8_t choice) const {
+        return backyardChoices[frontyardBucket][choice];
+    }
+
+    //Same as insertOverflow in the filter
+    bool insertOverflow(size_t frontyardBucket, uint8_t miniBucketIndex) {
+        uint8_t choice = 0;
+        for(uint8_t k = 1; k < g.backyardChoices; k++) {
+            if(backyardFill[backyardBucket(frontyardBucket, k)] <= backyardFill[backyardBucket(frontyardBucket, choice)]) {
+                choice = k;
+            }
+        }
+        size_t& fill = backyardFill[backyardBucket(frontyardBucket, choice)];
+        if(fill >= g.backyardCapacity) {
+            return false;
+        }
+        fill++;
+        overflowed[frontyardBucket].push_back({miniBucketIndex, choice});
+        return true;
+    }
+
+    void forgetKey(size_t frontyardBucket, uint8_t miniBucketIndex) {
+        auto it = find(liveKeys.begin(), liveKeys.end(), make_pair(static_cast<uint32_t>(frontyardBucket), miniBucketIndex));
+        *it = liveKeys.back();
+        liveKeys.pop_back();
+    }
+
+    public:
+        size_t nominalCapacity;
+
+        GeometrySimulation(const Geometry& g, size_t numFrontyardBuckets, uint64_t seed):
+            g{g},
+            numBackyardBuckets{(numFrontyardBuckets + g.ratio - 1)/g.ratio + g.ratio*2},
+            frontyard(numFrontyardBuckets),
+            overflowed(numFrontyardBuckets),
+            backyardFill(numBackyardBuckets),
+            generator(seed),
+            //Same as PartitionQuotientFilter::NormalizingFactor * NumMiniBuckets * numFrontyardBuckets
+            nominalCapacity{static_cast<size_t>(numFrontyardBuckets * g.frontyardCapacity * (1 + (double)g.backyardBucketSize/(g.ratio*g.frontyardBucketSize)))}
+        {
+            //Same R as the filter constructor
+            size_t R = numFrontyardBuckets / g.ratio / g.ratio + 1;
+            if(R % (g.ratio - 1) == 0) R++;
+            backyardChoices = getBackyardChoicesForRatio(g.ratio, numFrontyardBuckets, numBackyardBuckets, R);
+        }
+
+        size_t numKeys() const {
+            return liveKeys.size();
+        }
+
+        double load() const {
+            return (double)liveKeys.size() / nominalCapacity;
+        }
+
+        double bitsPerKey() const {
+            return 8.0 * (frontyard.size()*g.frontyardBucketSize + numBackyardBuckets*g.backyardBucketSize) / liveKeys.size();
+        }
+
+        double averageBackyardFill() const {
+            size_t total = 0;
+            for(size_t fill: backyardFill) total += fill;
+            return (double)total / numBackyardBuckets / g.backyardCapacity;
+        }
+
+        size_t maxBackyardFill() const {
+            return *max_element(backyardFill.begin(), backyardFill.end());
+        }
+
+        //Returns false if the backyard had no room, in which case the filter would have lost a key
+        bool insert() {
+            size_t frontyardBucket = generator() % frontyard.size();
+            uint8_t miniBucketIndex = generator() % g.numMiniBuckets;
+            vector<uint8_t>& bucket = frontyard[frontyardBucket];
+            bucket.insert(upper_bound(bucket.begin(), bucket.end(), miniBucketIndex), miniBucketIndex);
+            liveKeys.push_back({frontyardBucket, miniBucketIndex});
+            if(bucket.size() <= g.frontyardCapacity) {
+                return true;
+            }
+            uint8_t pushedOut = bucket.back();
+            bucket.pop_back();
+            if(!insertOverflow(frontyardBucket, pushedOut)) {
+                forgetKey(frontyardBucket, pushedOut);
+                return false;
+            }
+            return true;
+        }
+
+        void removeRandom() {
+            size_t keyIndex = generator() % liveKeys.size();
+            auto [frontyardBucket, miniBucketIndex] = liveKeys[keyIndex];
+            liveKeys[keyIndex] = liveKeys.back();
+            liveKeys.pop_back();
+
+            //Keys in the same mini bucket can be split between the frontyard and the backyard; which copy the remainder matches is random
+            vector<uint8_t>& bucket = frontyard[frontyardBucket];
+            vector<OverflowedKey>& overflow = overflowed[frontyardBucket];
+            auto [frontyardBegin, frontyardEnd] = equal_range(bucket.begin(), bucket.end(), miniBucketIndex);
+            size_t inFrontyard = frontyardEnd - frontyardBegin;
+            size_t inBackyard = count_if(overflow.begin(), overflow.end(), [&](OverflowedKey k) {return k.miniBucketIndex == miniBucketIndex;});
+            if(generator() % (inFrontyard + inBackyard) < inFrontyard) {
+                bucket.erase(frontyardBegin);
+                if(!overflow.empty()) {
+                    auto smallest = min_element(overflow.begin(), overflow.end(), [](OverflowedKey a, OverflowedKey b) {return a.miniBucketIndex < b.miniBucketIndex;});
+                    backyardFill[backyardBucket(frontyardBucket, smallest->choice)]--;
+                    bucket.insert(upper_bound(bucket.begin(), bucket.end(), smallest->miniBucketIndex), smallest->miniBucketIndex);
+                    *smallest = overflow.back();
+                    overflow.pop_back();
+                }
+            }
+            else {
+                auto it = find_if(overflow.begin(), overflow.end(), [&](OverflowedKey k) {return k.miniBucketIndex == miniBucketIndex;});
+                backyardFill[backyardBucket(frontyardBucket, it->choice)]--;
+                *it = overflow.back();
+                overflow.pop_back();
+            }
+        }
+
+        //A query has to go on to the backyard when its frontyard bucket is full and no key there is in a later mini bucket (Bucket::query returning 2)
+        bool goesToBackyard(size_t frontyardBucket, uint8_t miniBucketIndex) const {
+            const vector<uint8_t>& bucket = frontyard[frontyardBucket];
+            return bucket.size() == g.frontyardCapacity && bucket.back() <= miniBucketIndex;
+        }
+
+        double negativeProbeRate(size_t samples) {
+            size_t probes = 0;
+            for(size_t i{0}; i < samples; i++) {
+                probes += goesToBackyard(generator() % frontyard.size(), generator() % g.numMiniBuckets);
+            }
+            return (double)probes / samples;
+        }
+
+        double positiveProbeRate(size_t samples) {
+            size_t probes = 0;
+            for(size_t i{0}; i < samples; i++) {
+                auto [frontyardBucket, miniBucketIndex] = liveKeys[generator() % liveKeys.size()];
+                probes += goesToBackyard(frontyardBucket, miniBucketIndex);
+            }
+            return (double)probes / samples;
+        }
+};
+
+struct TrialResult {
+    double failureLoad;
+    double bitsPerKeyAtFailure;
+    array<double, Checkpoints.size()> negativeProbeRates{};
+    array<double, Checkpoints.size()> positiveProbeRates{};
+    array<double, Checkpoints.size()> backyardFills{};
+    size_t checkpointsReached = 0;
+    bool churned = false;
+    size_t churnOps = 0;
+    size_t churnFailures = 0;
+    double backyardFillBeforeChurn = 0;
+    double backyardFillAfterChurn = 0;
+    size_t maxBackyardFillAfterChurn = 0;
+};
+
+TrialResult runTrial(const Geometry& g, size_t numFrontyardBuckets, uint64_t seed) {
+    constexpr size_t ProbeSamples = 100000;
+    TrialResult result;
+    {
+        //Fill until the first insert the backyard has no room for
+        GeometrySimulation sim(g, numFrontyardBuckets, seed);
+        while(sim.insert()) {
+            if(result.checkpointsReached < Checkpoints.size() && sim.load() >= Checkpoints[result.checkpointsReached]) {
+                result.negativeProbeRates[result.checkpointsReached] = sim.negativeProbeRate(ProbeSamples);
+                result.positiveProbeRates[result.checkpointsReached] = sim.positiveProbeRate(ProbeSamples);
+                result.backyardFills[result.checkpointsReached] = sim.averageBackyardFill();
+                result.checkpointsReached++;
+            }
+        }
+        result.failureLoad = sim.load();
+        result.bitsPerKeyAtFailure = sim.bitsPerKey();
+    }
+    {
+        //Deletion churn at a fixed load: the backyard does not drain as fast as it fills, since a frontyard delete only pulls back one overflowed key
+        GeometrySimulation sim(g, numFrontyardBuckets, seed ^ 0x9E3779B97F4A7C15ull);
+        while(sim.load() < ChurnLoad) {
+            if(!sim.insert()) return result;
+        }
+        result.churned = true;
+        result.backyardFillBeforeChurn = sim.averageBackyardFill();
+        result.churnOps = sim.numKeys() * ChurnRounds;
+        for(size_t i{0}; i < result.churnOps; i++) {
+            sim.removeRandom();
+            result.churnFailures += !sim.insert();
+        }
+        result.backyardFillAfterChurn = sim.averageBackyardFill();
+        result.maxBackyardFillAfterChurn = sim.maxBackyardFill();
+    }
+    return result;
+}
+
+void simulate(const Geometry& g, size_t numFrontyardBuckets, size_t numTrials) {
+    vector<TrialResult> results(numTrials);
+    atomic<size_t> nextTrial{0};
+    uint64_t baseSeed = random_device()();
+    vector<thread> threads;
+    for(size_t t{0}; t < max(1u, thread::hardware_concurrency()); t++) {
+        threads.emplace_back([&] () -> void {
+            for(size_t trial = nextTrial++; trial < numTrials; trial = nextTrial++) {
+                results[trial] = runTrial(g, numFrontyardBuckets, baseSeed + trial);
+            }
+        });
+    }
+    for(thread& t: threads) t.join();
+
+    double predictedKeysPerBucket = ConfigOptimizerDetail::maxKeysPerBucket(g.frontyardCapacity, (g.backyardCapacity - ConfigOptimizerDetail::BackyardSlack)/g.ratio);
+    double predictedLoad = predictedKeysPerBucket / (g.frontyardCapacity * (1 + (double)g.backyardBucketSize/(g.ratio*g.frontyardBucketSize)));
+
+    double meanLoad = 0, minLoad = 1e9, meanBitsPerKey = 0;
+    for(const TrialResult& r: results) {
+        meanLoad += r.failureLoad / numTrials;
+        minLoad = min(minLoad, r.failureLoad);
+        meanBitsPerKey += r.bitsPerKeyAtFailure / numTrials;
+    }
+    cout << g.name << " (" << g.numMiniBuckets << " mini buckets, capacities " << g.frontyardCapacity << "/" << g.backyardCapacity << ", ratio " << g.ratio << ", " << g.frontyardBucketSize << "/" << g.backyardBucketSize << " byte buckets, " << g.backyardChoices << " backyard choices)" << endl;
+    cout << "  First failure at load " << meanLoad << " (min " << minLoad << "), " << meanBitsPerKey << " bits per key there; ConfigOptimizer plans for load " << predictedLoad << endl;
+    for(size_t c{0}; c < Checkpoints.size(); c++) {
+        size_t reached = 0;
+        double negative = 0, positive = 0, fill = 0;
+        for(const TrialResult& r: results) {
+            if(r.checkpointsReached > c) {
+                reached++;
+                negative += r.negativeProbeRates[c];
+                positive += r.positiveProbeRates[c];
+                fill += r.backyardFills[c];
+            }
+        }
+        if(reached == 0) break;
+        cout << "  At load " << Checkpoints[c] << " (" << reached << "/" << numTrials << " trials): backyard probes for " << negative/reached << " of negative and " << positive/reached << " of positive queries, backyard " << fill/reached << " full" << endl;
+    }
+    size_t churned = 0, churnOps = 0, churnFailures = 0, maxFill = 0;
+    double fillBefore = 0, fillAfter = 0;
+    for(const TrialResult& r: results) {
+        if(!r.churned) continue;
+        churned++;
+        churnOps += r.churnOps;
+        churnFailures += r.churnFailures;
+        fillBefore += r.backyardFillBeforeChurn;
+        fillAfter += r.backyardFillAfterChurn;
+        maxFill = max(maxFill, r.maxBackyardFillAfterChurn);
+    }
+    if(churned > 0) {
+        cout << "  Churn at load " << ChurnLoad << ": " << 1e6*churnFailures/churnOps << " failures per million delete/insert pairs, backyard " << fillBefore/churned << " full before and " << fillAfter/churned << " after, fullest bucket " << maxFill << "/" << g.backyardCapacity << endl;
+    }
+    else {
+        cout << "  Churn at load " << ChurnLoad << ": never reached" << endl;
+    }
+}
+
+template<size_t SizeRemainders, size_t FrontyardBucketSize, size_t BackyardBucketSize = FrontyardBucketSize>
+Geometry optimizedGeometry(string name) {
+    constexpr FilterGeometry g = OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize>;
+    return {name, g.BucketNumMiniBuckets, g.FrontyardBucketCapacity, g.BackyardBucketCapacity, g.FrontyardToBackyardRatio, FrontyardBucketSize, BackyardBucketSize};
+}
+
+int main(int argc, char* argv[]) {
+    size_t numFrontyardBuckets = 1ull << 16;
+    size_t numTrials = max(1u, thread::hardware_concurrency());
+    if(argc > 1) {
+        numFrontyardBuckets = 1ull << atoi(argv[1]);
+    }
+    if(argc > 2) {
+        numTrials = atoi(argv[2]);
+    }
+
+    vector<Geometry> geometries;
+    if(argc > 8) {
+        geometries.push_back({"Custom", stoul(argv[3]), stoul(argv[4]), stoul(argv[5]), stoul(argv[6]), stoul(argv[7]), stoul(argv[8])});
+        if(argc > 9) {
+            geometries.back().backyardChoices = stoul(argv[9]);
+            if(geometries.back().backyardChoices < 2 || geometries.back().backyardChoices > MaxBackyardChoices) {
+                throw invalid_argument("The number of backyard choices has to be between 2 and " + to_string(MaxBackyardChoices));
+            }
+        }
+    }
+    else {
+        geometries = {
+            {"PQF_8_22", 22, 26, 18, 8, 32, 32},
+            {"PQF_8_31", 31, 25, 17, 8, 32, 32},
+            {"PQF_8_22BB", 22, 26, 37, 8, 32, 64},
+            {"PQF_8_62", 62, 50, 34, 8, 64, 64},
+            {"PQF_8_53", 53, 51, 35, 8, 64, 64},
+            {"PQF_16_36", 36, 28, 22, 8, 64, 64},
+            {"PQF_8_22_D3", 22, 26, 16, 8, 32, 32, 3},
+            {"PQF_8_22_D4", 22, 26, 16, 8, 32, 32, 4},
+            {"PQF_16_36_D4", 36, 28, 21, 8, 64, 64, 4},
+            {"PQF_8_62, ratio 16", 62, 50, 32, 16, 64, 64},
+            optimizedGeometry<16, 64>("OptimizedPQF<16, 64>"),
+            optimizedGeometry<8, 32, 64>("OptimizedPQF<8, 32, 64>"),
+        };
+    }
+
+    for(const Geometry& g: geometries) {
+        simulate(g, numFrontyardBuckets, numTrials);
+    }
+}
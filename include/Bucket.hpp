@@ -7,13 +7,14 @@
 #include "RemainderStore.hpp"
 
 namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
     //Maybe have a bit set to if the bucket is not overflowed? Cause right now the bucket may send you to the backyard even if there is nothing in the backyard, but the bucket is just full. Not that big a deal, but this slight optimization might be worth a bit?
     //Like maybe have one extra key in the minifilter and then basically account for that or smth? Not sure.
-    template<std::size_t SizeRemainders, std::size_t NumKeys, std::size_t NumMiniBuckets, template<std::size_t> typename TypeOfQRContainerTemplate, std::size_t Size, bool FastSQuery, bool Threaded>
+    template<std::size_t SizeRemainders, std::size_t NumKeys, std::size_t NumMiniBuckets, template<std::size_t> typename TypeOfQRContainerTemplate, std::size_t Size, bool FastSQuery, bool Threaded, SelectType Select = SelectType::Pdep, template<std::size_t, std::size_t, std::size_t> typename TypeOfRemainderStoreTemplate = RemainderStore>
     struct alignas(Size) Bucket {
-        using TypeOfMiniFilter = MiniFilter<NumKeys, NumMiniBuckets, Threaded>;
+        using TypeOfMiniFilter = MiniFilter<NumKeys, NumMiniBuckets, Threaded, Select>;
         TypeOfMiniFilter miniFilter;
-        using TypeOfRemainderStore = RemainderStore<SizeRemainders, NumKeys, TypeOfMiniFilter::Size>;
+        using TypeOfRemainderStore = TypeOfRemainderStoreTemplate<SizeRemainders, NumKeys, TypeOfMiniFilter::Size>;
         TypeOfRemainderStore remainderStore;
         using TypeOfQRContainer = TypeOfQRContainerTemplate<NumMiniBuckets>;
         
@@ -97,6 +98,37 @@ namespace PQF {
             }
         }
 
+        //Same return values as query, but matches if any of the remainders is in the mini bucket. Used with epoch tags, where the same fingerprint may be stored under any of the live tags, so that the bounds are only computed once.
+        //Does not have a FastSQuery version
+        inline std::uint64_t queryAny(TypeOfQRContainer qr, const std::uint64_t* remainders, std::size_t numRemainders) {
+            std::pair<std::uint64_t, std::uint64_t> boundsMask = miniFilter.queryMiniBucketBoundsMask(qr.miniBucketIndex);
+            for(std::size_t i=0; i < numRemainders; i++) {
+                if(remainderStore.queryVectorizedMask(remainders[i], boundsMask.second - boundsMask.first) != 0)
+                    return 1;
+            }
+            return boundsMask.second == (1ull << NumKeys) ? 2 : 0;
+        }
+
+        //Fused query and insert: returns 1 if found it, 2 if need to go to backyard (and nothing was inserted), 0 if it was not there and got inserted, in which case qr holds the overflow like insert returns.
+        //Reuses the bounds of the query as the insert location, so the mini filter only gets selected on once
+        inline std::uint64_t queryOrInsert(TypeOfQRContainer& qr) {
+            std::pair<std::uint64_t, std::uint64_t> boundsMask = miniFilter.queryMiniBucketBoundsMask(qr.miniBucketIndex);
+            std::uint64_t inFilter = remainderStore.queryVectorizedMask(qr.remainder, boundsMask.second - boundsMask.first);
+            if(inFilter != 0) {
+                return 1;
+            }
+            else if (boundsMask.second == (1ull << NumKeys)) {
+                return 2;
+            }
+            std::size_t loc = __builtin_ctzll(boundsMask.first);
+            if constexpr (DEBUG) {
+                assert(loc == miniFilter.queryMiniBucketBeginning(qr.miniBucketIndex));
+            }
+            qr.miniBucketIndex = miniFilter.insert(qr.miniBucketIndex, loc);
+            qr.remainder = remainderStore.insert(qr.remainder, loc);
+            return 0;
+        }
+
         //Returns true if deleted, false if need to go to backyard (we assume that key exists, so we don't expect to not find it somewhere)
         inline bool remove(TypeOfQRContainer qr) {
             std::pair<std::uint64_t, std::uint64_t> boundsMask = miniFilter.queryMiniBucketBoundsMask(qr.miniBucketIndex);
@@ -146,7 +178,16 @@ namespace PQF {
                 v.push_back(x);
             }
         }
+
+        //Same as deconstruct but streams the (miniBucket, remainder) pairs to f instead of building a vector
+        template<typename F>
+        inline void forEach(F&& f) const {
+            miniFilter.forEachKey([&](std::size_t keyIndex, std::size_t miniBucketIndex) {
+                f(miniBucketIndex, remainderStore.get(keyIndex));
+            });
+        }
     };
 }
+}
 
 #endif
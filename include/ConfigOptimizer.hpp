@@ -0,0 +1,188 @@
+#ifndef CONFIG_OPTIMIZER_HPP
+#define CONFIG_OPTIMIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <utility>
+#include "PartitionQuotientFilter.hpp"
+
+//Compile time version of the search in Configurations/StandardConfigOptimizer.cpp: given the stored remainder size, the bucket sizes and whether the filter is threaded, picks the number of mini buckets, both bucket capacities and the frontyard to backyard ratio.
+//The model: keys land in frontyard buckets as a Poisson process with mean lambda per bucket, whatever does not fit spills to the backyard, and each backyard bucket (fed by FrontyardToBackyardRatio frontyard buckets on average) is only planned to be filled to BackyardSlack keys short of capacity.
+//lambda is pushed as high as that allows, and the geometry minimizing the bits per key above the information theoretic minimum for its false positive rate (about lambda/NumMiniBuckets * 2^-SizeRemainders) wins.
+//With 8 and 16 bit remainders this lands on the shipped PQF_8_22, PQF_8_62, PQF_16_36 and their threaded versions (the latter with a ratio of 6 rather than 8); the aliases for the other widths and PQF_16_55_128 (128 byte frontyard buckets, which only 16 bit remainders have a store for) come from it.
+namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
+    struct FilterGeometry {
+        std::size_t BucketNumMiniBuckets = 0;
+        std::size_t FrontyardBucketCapacity = 0;
+        std::size_t BackyardBucketCapacity = 0;
+        std::size_t FrontyardToBackyardRatio = 0;
+        double keysPerFrontyardBucket = 0; //The lambda the geometry was optimized for
+        double bitsPerKey = 0; //At that load
+        double overheadBits = 0; //bitsPerKey minus log2(1/false positive rate)
+        double load = 0; //keysPerFrontyardBucket as a fraction of what filling the filter to the N it was constructed with works out to
+    };
+
+    namespace ConfigOptimizerDetail {
+        //Keys a backyard bucket is expected to have room left for at the planned load, to absorb the variance of the overflow it gets. Same as in StandardConfigOptimizer.cpp.
+        inline constexpr double BackyardSlack = 8;
+        //BackyardQRContainer needs at least 2 frontyard buckets per backyard bucket. Past 16 the backyard buckets get too few keys from each frontyard bucket to be worth the wider tag.
+        inline constexpr std::size_t MinFrontyardToBackyardRatio = 2;
+        inline constexpr std::size_t MaxFrontyardToBackyardRatio = 16;
+
+        //Same as BackyardQRContainer<..., ratio>::TagBits
+        inline constexpr std::size_t backyardTagBits(std::size_t ratio) {
+            std::size_t tagBits = 4;
+            while((1ull << (tagBits - 1)) < ratio) tagBits++;
+            return tagBits;
+        }
+
+        //The frontyard remainder sizes RemainderStore has a specialization for. The backyard uses the same store with one for the tag next to it (BackyardRemainderStore).
+        inline constexpr bool supportedRemainderSize(std::size_t size) {
+            return size == 5 || size == 6 || size == 7 || size == 8 || size == 10 || size == 12 || size == 16 || size == 20 || size == 24 || size == 32;
+        }
+
+        //Same as RemainderStore<Size, NumRemainders, Offset>::Size, the pieces of the stores past 16 bits included
+        inline constexpr std::size_t remainderStoreBytes(std::size_t size, std::size_t numRemainders) {
+            return (size*numRemainders + 7)/8;
+        }
+
+        //Whether a bucket with these parameters satisfies the static_asserts of Bucket, MiniFilter and RemainderStore. Backyard buckets (tagBits > 0) hold the tag store as well.
+        inline constexpr bool bucketFits(std::size_t remainderSize, std::size_t numKeys, std::size_t numMiniBuckets, std::size_t bucketSize, bool threaded, std::size_t tagBits) {
+            std::size_t miniFilterBytes = (numKeys + numMiniBuckets + 7)/8;
+            if(numKeys == 0 || numKeys >= 64 || miniFilterBytes > (bucketSize > 64 ? 32 : 16)) return false; //Only 128 byte buckets get the multi word mini filter
+            if(threaded && numKeys + numMiniBuckets == miniFilterBytes*8) return false; //No spare bit for the lock
+            if(remainderSize >= 16 && miniFilterBytes % 2 != 0) return false; //16 bit stores need to be 2 byte aligned
+            std::size_t storeBytes = remainderStoreBytes(remainderSize, numKeys);
+            if(tagBits > 0) {
+                if(remainderSize >= 16) storeBytes += storeBytes % 2; //The tag store goes after the padding of the 2 byte aligned one
+                storeBytes += remainderStoreBytes(tagBits, numKeys);
+            }
+            return miniFilterBytes + storeBytes <= bucketSize;
+        }
+
+        inline constexpr std::size_t maxCapacity(std::size_t remainderSize, std::size_t numMiniBuckets, std::size_t bucketSize, bool threaded, std::size_t tagBits) {
+            for(std::size_t numKeys = 63; numKeys > 0; numKeys--) {
+                if(bucketFits(remainderSize, numKeys, numMiniBuckets, bucketSize, threaded, tagBits)) {
+                    return numKeys;
+                }
+            }
+            return 0;
+        }
+
+        inline constexpr double constexprExp(double x) {
+            std::size_t halvings = 0;
+            while(x > 0.5 || x < -0.5) {
+                x /= 2;
+                halvings++;
+            }
+            double term = 1, sum = 1;
+            for(std::size_t i = 1; i < 20; i++) {
+                term *= x/i;
+                sum += term;
+            }
+            for(; halvings > 0; halvings--) {
+                sum *= sum;
+            }
+            return sum;
+        }
+
+        inline constexpr double constexprLog2(double x) {
+            double exponent = 0;
+            while(x >= 2) {
+                x /= 2;
+                exponent++;
+            }
+            while(x < 1) {
+                x *= 2;
+                exponent--;
+            }
+            //ln(x) = 2 atanh((x-1)/(x+1)), and (x-1)/(x+1) <= 1/3 here
+            double y = (x-1)/(x+1), power = y, lnx = 0;
+            for(std::size_t i = 1; i < 40; i += 2) {
+                lnx += power/i;
+                power *= y*y;
+            }
+            return exponent + 2*lnx/0.69314718055994530942;
+        }
+
+        //Expected keys past the first capacity of a Poisson(lambda) bucket, and its derivative in lambda (the probability there are at least capacity keys)
+        inline constexpr std::pair<double, double> expectedOverflow(double lambda, std::size_t capacity) {
+            double probability = constexprExp(-lambda);
+            double below = 0, expectedBelow = 0;
+            for(std::size_t k = 0; k < capacity; k++) {
+                below += probability;
+                expectedBelow += k*probability;
+                probability *= lambda/(k+1);
+            }
+            return {lambda - expectedBelow - capacity*(1-below), 1-below};
+        }
+
+        //Largest lambda whose expected overflow is at most maxOverflow. The overflow is convex and increasing in lambda and at least lambda - capacity, so Newton's method started from capacity + maxOverflow walks down onto it.
+        inline constexpr double maxKeysPerBucket(std::size_t capacity, double maxOverflow) {
+            double lambda = capacity + maxOverflow;
+            for(std::size_t i = 0; i < 100; i++) {
+                auto [overflow, slope] = expectedOverflow(lambda, capacity);
+                double step = (overflow - maxOverflow)/slope;
+                lambda -= step;
+                if(step < 1e-9) break;
+            }
+            return lambda;
+        }
+
+        inline constexpr FilterGeometry optimizeGeometry(std::size_t sizeRemainders, std::size_t frontyardBucketSize, std::size_t backyardBucketSize, bool threaded) {
+            FilterGeometry best;
+            //Consecutive mini bucket counts mostly share capacities, so the lambdas only get solved for when those change
+            std::array<std::pair<std::size_t, std::size_t>, MaxFrontyardToBackyardRatio+1> solvedCapacities{};
+            std::array<double, MaxFrontyardToBackyardRatio+1> lambdas{};
+            for(std::size_t numMiniBuckets = 1; numMiniBuckets < 128; numMiniBuckets++) {
+                //More keys per bucket only ever helps, so each mini bucket count only needs the largest capacities that fit
+                std::size_t frontyardCapacity = maxCapacity(sizeRemainders, numMiniBuckets, frontyardBucketSize, threaded, 0);
+                if(frontyardCapacity == 0) continue;
+                //The backyard capacity depends on the ratio through the tag width, which only has a couple of values
+                std::array<std::size_t, backyardTagBits(MaxFrontyardToBackyardRatio)+1> backyardCapacities{};
+                for(std::size_t tagBits = backyardTagBits(MinFrontyardToBackyardRatio); tagBits <= backyardTagBits(MaxFrontyardToBackyardRatio); tagBits++) {
+                    backyardCapacities[tagBits] = maxCapacity(sizeRemainders, numMiniBuckets, backyardBucketSize, threaded, tagBits);
+                }
+                for(std::size_t ratio = MinFrontyardToBackyardRatio; ratio <= MaxFrontyardToBackyardRatio; ratio++) {
+                    std::size_t backyardCapacity = backyardCapacities[backyardTagBits(ratio)];
+                    if(backyardCapacity <= BackyardSlack) continue;
+                    if(solvedCapacities[ratio] != std::make_pair(frontyardCapacity, backyardCapacity)) {
+                        lambdas[ratio] = maxKeysPerBucket(frontyardCapacity, (backyardCapacity - BackyardSlack)/ratio);
+                        solvedCapacities[ratio] = {frontyardCapacity, backyardCapacity};
+                    }
+                    double lambda = lambdas[ratio];
+                    double bitsPerKey = 8.0 * (frontyardBucketSize + (double)backyardBucketSize/ratio) / lambda;
+                    double overheadBits = bitsPerKey - sizeRemainders - constexprLog2(numMiniBuckets/lambda);
+                    if(best.BucketNumMiniBuckets == 0 || overheadBits < best.overheadBits) {
+                        //Same as PartitionQuotientFilter::NormalizingFactor*numMiniBuckets
+                        double keysPerBucketAtN = frontyardCapacity * (1 + (double)backyardBucketSize/(ratio*frontyardBucketSize));
+                        best = {numMiniBuckets, frontyardCapacity, backyardCapacity, ratio, lambda, bitsPerKey, overheadBits, lambda/keysPerBucketAtN};
+                    }
+                }
+            }
+            return best;
+        }
+    }
+
+    template<std::size_t SizeRemainders, std::size_t FrontyardBucketSize = 64, std::size_t BackyardBucketSize = FrontyardBucketSize, bool Threaded = false>
+    inline constexpr FilterGeometry OptimalGeometry = [] {
+        static_assert(ConfigOptimizerDetail::supportedRemainderSize(SizeRemainders), "No remainder stores for this remainder size");
+        static_assert(FrontyardBucketSize == 32 || FrontyardBucketSize == 64 || (FrontyardBucketSize == 128 && SizeRemainders == 16), "128 byte buckets are only supported with 16 bit remainders");
+        static_assert(BackyardBucketSize == 32 || BackyardBucketSize == 64);
+        return ConfigOptimizerDetail::optimizeGeometry(SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded);
+    }();
+
+    //A PartitionQuotientFilter with the geometry from OptimalGeometry. Epoch tags (or any other payload kept in the remainder) count towards SizeRemainders; they only scale the false positive rate, so they do not change the geometry.
+    template<std::size_t SizeRemainders, std::size_t FrontyardBucketSize = 64, std::size_t BackyardBucketSize = FrontyardBucketSize, bool FastSQuery = false, bool Threaded = false, std::size_t EpochBits = 0, bool LazyBackyard = false, SelectType Select = SelectType::Pdep>
+    using OptimizedPQF = PartitionQuotientFilter<SizeRemainders,
+        OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded>.BucketNumMiniBuckets,
+        OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded>.FrontyardBucketCapacity,
+        OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded>.BackyardBucketCapacity,
+        OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded>.FrontyardToBackyardRatio,
+        FrontyardBucketSize, BackyardBucketSize, FastSQuery, Threaded, EpochBits, LazyBackyard, Select>;
+}
+}
+
+#endif
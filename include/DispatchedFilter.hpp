@@ -0,0 +1,50 @@
+#ifndef DISPATCHED_FILTER_HPP
+#define DISPATCHED_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+//ISA independent front end to filters whose bucket kernels were compiled for AVX512, AVX2 and plain x86-64 (src/DispatchAVX512.cpp, src/DispatchAVX2.cpp and src/DispatchScalar.cpp), so that one binary runs at full speed on the first two and still runs on anything else.
+//The instruction set is picked once, when the filter is constructed; after that every call is a virtual call, so use the batch functions in hot loops to pay for it once per batch rather than once per key.
+namespace PQF {
+    enum class ISA {Scalar, AVX2, AVX512};
+
+    //The configurations that get compiled for every instruction set. Same geometry as the PQF_* aliases of the same name.
+    enum class DispatchedConfig {
+        PQF_8_22, PQF_8_22_FRQ, PQF_8_22BB, PQF_8_31, PQF_8_62, PQF_8_53, PQF_8_53_FRQ, PQF_16_36, PQF_16_36_FRQ,
+        PQF_8_21_T, PQF_8_52_T, PQF_16_35_T
+    };
+
+    class FilterInterface {
+        public:
+            virtual ~FilterInterface() = default;
+
+            virtual bool insert(std::uint64_t hash) = 0;
+            virtual bool query(std::uint64_t hash) = 0;
+            virtual bool remove(std::uint64_t hash) = 0;
+
+            virtual void insertBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) = 0;
+            virtual void queryBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) = 0;
+            virtual void removeBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) = 0;
+
+            //Hashes have to be less than this
+            virtual std::uint64_t range() const = 0;
+            virtual std::uint64_t sizeFilter() = 0;
+            virtual ISA isa() const = 0;
+    };
+
+    //The best instruction set this CPU supports. AVX512 needs the F, BW, VL, VBMI, VBMI2 and BITALG extensions and AVX2 needs x86-64-v3 (AVX2 and BMI2); Scalar uses no extensions and is the fallback for everything else.
+    ISA detectISA();
+
+    //Throws std::invalid_argument if asked for an ISA the CPU does not support
+    std::unique_ptr<FilterInterface> makeDispatchedFilter(DispatchedConfig config, std::size_t N, std::optional<ISA> isa = {});
+
+    std::unique_ptr<FilterInterface> makeFilterAVX512(DispatchedConfig config, std::size_t N);
+    std::unique_ptr<FilterInterface> makeFilterAVX2(DispatchedConfig config, std::size_t N);
+    std::unique_ptr<FilterInterface> makeFilterScalar(DispatchedConfig config, std::size_t N);
+}
+
+#endif
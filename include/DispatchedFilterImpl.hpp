@@ -0,0 +1,79 @@
+#ifndef DISPATCHED_FILTER_IMPL_HPP
+#define DISPATCHED_FILTER_IMPL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "DispatchedFilter.hpp"
+#include "PartitionQuotientFilter.hpp"
+
+//Only meant to be included by the per ISA dispatch translation units; everything here lands in the ISA namespace those were compiled for.
+namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
+    template<typename FilterType>
+    class DispatchedFilterImpl final : public FilterInterface {
+        FilterType filter;
+
+        public:
+            DispatchedFilterImpl(std::size_t N): filter(N) {}
+
+            bool insert(std::uint64_t hash) override {
+                return filter.insert(hash);
+            }
+
+            bool query(std::uint64_t hash) override {
+                return filter.query(hash);
+            }
+
+            bool remove(std::uint64_t hash) override {
+                return filter.remove(hash);
+            }
+
+            void insertBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) override {
+                filter.insertBatch(hashes, status, num_keys);
+            }
+
+            void queryBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) override {
+                filter.queryBatch(hashes, status, num_keys);
+            }
+
+            void removeBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) override {
+                filter.removeBatch(hashes, status, num_keys);
+            }
+
+            std::uint64_t range() const override {
+                return filter.range;
+            }
+
+            std::uint64_t sizeFilter() override {
+                return filter.sizeFilter();
+            }
+
+            ISA isa() const override {
+                return PQF_AVX512 ? ISA::AVX512 : (PQF_SCALAR ? ISA::Scalar : ISA::AVX2);
+            }
+    };
+
+    inline std::unique_ptr<FilterInterface> makeISAFilter(DispatchedConfig config, std::size_t N) {
+        switch(config) {
+            case DispatchedConfig::PQF_8_22: return std::make_unique<DispatchedFilterImpl<PQF_8_22>>(N);
+            case DispatchedConfig::PQF_8_22_FRQ: return std::make_unique<DispatchedFilterImpl<PQF_8_22_FRQ>>(N);
+            case DispatchedConfig::PQF_8_22BB: return std::make_unique<DispatchedFilterImpl<PQF_8_22BB>>(N);
+            case DispatchedConfig::PQF_8_31: return std::make_unique<DispatchedFilterImpl<PQF_8_31>>(N);
+            case DispatchedConfig::PQF_8_62: return std::make_unique<DispatchedFilterImpl<PQF_8_62>>(N);
+            case DispatchedConfig::PQF_8_53: return std::make_unique<DispatchedFilterImpl<PQF_8_53>>(N);
+            case DispatchedConfig::PQF_8_53_FRQ: return std::make_unique<DispatchedFilterImpl<PQF_8_53_FRQ>>(N);
+            case DispatchedConfig::PQF_16_36: return std::make_unique<DispatchedFilterImpl<PQF_16_36>>(N);
+            case DispatchedConfig::PQF_16_36_FRQ: return std::make_unique<DispatchedFilterImpl<PQF_16_36_FRQ>>(N);
+            case DispatchedConfig::PQF_8_21_T: return std::make_unique<DispatchedFilterImpl<PQF_8_21_T>>(N);
+            case DispatchedConfig::PQF_8_52_T: return std::make_unique<DispatchedFilterImpl<PQF_8_52_T>>(N);
+            case DispatchedConfig::PQF_16_35_T: return std::make_unique<DispatchedFilterImpl<PQF_16_35_T>>(N);
+        }
+        throw std::invalid_argument("Unknown filter configuration");
+    }
+}
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef GENERATIONAL_FILTER_HPP
+#define GENERATIONAL_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "PartitionQuotientFilter.hpp"
+
+namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
+    //Sliding window filter (ex for deduplicating a stream over the last N minutes): a ring of NumGenerations filters where inserts go to the newest generation and queries check all of them, newest first.
+    //Expiring a generation does not touch any keys: expire() rotates an already cleared spare filter in as the new newest generation, which is O(1), and the oldest generation becomes the spare.
+    //The spare then needs to be cleared before the next expire(), which is what prepareSpare() is for (ex call it from a maintenance thread some time between expirations). If nobody did, expire() clears it itself.
+    //prepareSpare() may run concurrently with inserts and queries but not with expire().
+    template<typename FilterType, std::size_t NumGenerations>
+    class GenerationalFilter {
+        static_assert(NumGenerations >= 1);
+
+        private:
+            std::array<std::unique_ptr<FilterType>, NumGenerations> generations; //generations[newest] is the newest, generations[(newest+1) % NumGenerations] the oldest
+            std::unique_ptr<FilterType> spare;
+            std::size_t newest;
+            bool spareReady;
+
+            inline FilterType& generation(std::size_t age) {
+                return *generations[(newest + NumGenerations - age) % NumGenerations];
+            }
+
+        public:
+            std::size_t range;
+
+            //N is the capacity of each generation
+            GenerationalFilter(std::size_t N, bool Normalize = true): newest{0}, spareReady{true} {
+                for(auto& g: generations) {
+                    g = std::make_unique<FilterType>(N, Normalize);
+                }
+                spare = std::make_unique<FilterType>(N, Normalize);
+                range = generations[0]->range;
+            }
+
+            bool insert(std::uint64_t hash) {
+                return generation(0).insert(hash);
+            }
+
+            void insertBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) {
+                generation(0).insertBatch(hashes, status, num_keys);
+            }
+
+            //All the generations share a geometry, so the same hash lands in the same bucket index in each of them. Issue all the prefetches first so the misses overlap, then query newest to oldest
+            bool query(std::uint64_t hash) {
+                for(auto& g: generations) {
+                    g->prefetch(hash);
+                }
+                for(std::size_t age = 0; age < NumGenerations; age++) {
+                    if(generation(age).query(hash)) return true;
+                }
+                return false;
+            }
+
+            void queryBatch(const std::vector<size_t>& hashes, std::vector<bool>& status, const uint64_t num_keys) {
+                constexpr size_t bsize = 16;
+                for (size_t j=0; j < num_keys; j+=bsize) {
+                    for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
+                        for(auto& g: generations) {
+                            g->prefetch(hashes[i]);
+                        }
+                    }
+                    for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
+                        status[i] = false;
+                        for(std::size_t age = 0; age < NumGenerations && !status[i]; age++) {
+                            status[i] = generation(age).query(hashes[i]);
+                        }
+                    }
+                }
+            }
+
+            //Removes hash from the newest generation that has it
+            bool remove(std::uint64_t hash) {
+                for(std::size_t age = 0; age < NumGenerations; age++) {
+                    if(generation(age).query(hash)) {
+                        return generation(age).remove(hash);
+                    }
+                }
+                return false;
+            }
+
+            //Drops the oldest generation and starts a new, empty one
+            void expire() {
+                prepareSpare();
+                newest = (newest + 1) % NumGenerations;
+                std::swap(generations[newest], spare);
+                spareReady = false;
+            }
+
+            void prepareSpare() {
+                if(!spareReady) {
+                    spare->clear();
+                    spareReady = true;
+                }
+            }
+
+            std::uint64_t sizeFilter() {
+                std::uint64_t size = spare->sizeFilter();
+                for(auto& g: generations) {
+                    size += g->sizeFilter();
+                }
+                return size;
+            }
+    };
+}
+}
+
+#endif
@@ -5,20 +5,21 @@
 #include <cstring>
 #include <array>
 #include <utility>
-#include <immintrin.h>
 #include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <optional>
 #include <bit>
 #include "TestUtility.hpp"
+#include "Select.hpp"
 
 namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
     //You have to put the minifilter at the beginning of the bucket! Otherwise it may mess stuff up, since it does something admittedly kinda sus
     //Relies on little endian ordering
     //Definitely not fully optimized, esp given the fact that I'm being generic and allowing any mini filter size rather than basically mini filter has to fit in 2 words (ullongs)
     //TODO: Fix the organization of this (ex make some stuff public, some stuff private etc), and make an interface (this goes for all the things written so far).
-    template<std::size_t NumKeys, std::size_t NumMiniBuckets, bool Threaded=false>
+    template<std::size_t NumKeys, std::size_t NumMiniBuckets, bool Threaded=false, SelectType Select=SelectType::Pdep>
     struct alignas(1) MiniFilter {
         inline static constexpr std::size_t NumBits = NumKeys+NumMiniBuckets;
         inline static constexpr std::size_t NumBytes = (NumKeys+NumMiniBuckets+7)/8;
@@ -28,34 +29,48 @@ namespace PQF {
         inline static constexpr std::uint64_t lastBitMask = (NumBits%64 == 0) ? (1ull << 63) : (1ull << ((NumBits%64)-1));
         std::array<uint8_t, NumBytes> filterBytes;
 
-        static_assert(NumKeys < 64 && NumBytes <= 16); //Not supporting more cause I don't need it
+        static_assert(NumKeys < 64 && NumBytes <= 32); //Past 16 bytes only for the 128 byte buckets, which go through the generic multi word versions below
 
         inline static constexpr std::size_t LockMask = 1ull << (NumBits%64);
         inline static constexpr std::size_t UnlockMask = ~LockMask;
         static_assert(!Threaded || (NumBits < NumBytes*8)); //Making sure adding the bit doesn't make the filter bigger!
 
+        //The filter is stored XORed with the encoding of an empty filter (all the mini bucket separators first), so that an empty filter is all zero bytes.
+        //That way zeroed memory is already a valid empty bucket, and a filter can be built on untouched zero pages that only get faulted in once written to.
+        //Everything works on the decoded segments. The pattern only has bits inside the filter, so the bytes after it that get read along with the last segment pass through unchanged (as does the lock bit)
+        inline static constexpr std::array<std::uint64_t, NumUllongs+1> getEmptyPattern() {
+            std::array<std::uint64_t, NumUllongs+1> pattern{};
+            for(std::size_t i = 0; i < NumMiniBuckets; i++) {
+                pattern[i/64] |= 1ull << (i%64);
+            }
+            return pattern;
+        }
+
+        inline static constexpr std::array<std::uint64_t, NumUllongs+1> EmptyPattern = getEmptyPattern();
+
+        inline std::uint64_t getSegment(std::size_t i) const {
+            return reinterpret_cast<const uint64_t*> (&filterBytes)[i] ^ EmptyPattern[i];
+        }
+
+        inline void setSegment(std::size_t i, std::uint64_t segment) {
+            reinterpret_cast<uint64_t*> (&filterBytes)[i] = segment ^ EmptyPattern[i];
+        }
+
+        //The bytes of the filter as they would be without the XOR, for the testing functions
+        inline std::array<uint8_t, NumBytes> decodedBytes() const {
+            std::array<uint8_t, NumBytes> bytes = filterBytes;
+            for(std::size_t i{0}; i < NumBytes; i++) {
+                bytes[i] ^= static_cast<uint8_t>(EmptyPattern[i/8] >> (8*(i%8)));
+            }
+            return bytes;
+        }
+
         inline constexpr MiniFilter() {
-            int64_t numBitsNeedToSet = NumMiniBuckets;
             for(uint8_t& b: filterBytes) {
-                if(numBitsNeedToSet >= 8) {
-                    b = -1;
-                }
-                else if(numBitsNeedToSet > 0) {
-                    b = (1 << numBitsNeedToSet) - 1;
-                }
-                else {
-                    b = 0;
-                }
-                numBitsNeedToSet -= 8;
+                b = 0;
             }
             
             if constexpr (DEBUG) {
-                bool f = false;
-                for(uint8_t b: filterBytes) {
-                    if(b != 0)
-                        f = true;
-                }
-                assert(f);
                 assert(countKeys() == 0);
                 checkCorrectPopCount();
             }
@@ -88,12 +103,11 @@ namespace PQF {
         }
 
         inline bool full() const {
-            const uint64_t* fastCastFilter = reinterpret_cast<const uint64_t*> (&filterBytes);
-            return *(fastCastFilter + NumUllongs - 1) & lastBitMask; //If the last element is a miniBucket separator, we know we are full! Otherwise, there are keys "waiting" to be allocated to a mini bucket.
+            return getSegment(NumUllongs - 1) & lastBitMask; //If the last element is a miniBucket separator, we know we are full! Otherwise, there are keys "waiting" to be allocated to a mini bucket.
         }
 
         inline std::size_t select(uint64_t filterSegment, uint64_t miniBucketSegmentIndex) const {
-            uint64_t isolateBit = _pdep_u64(1ull << miniBucketSegmentIndex, filterSegment);
+            uint64_t isolateBit = selectBit<Select>(filterSegment, miniBucketSegmentIndex);
             // std::cout << miniBucketSegmentIndex << " " << isolateBit << std::endl;
             return __builtin_ctzll(isolateBit);
         }
@@ -103,84 +117,110 @@ namespace PQF {
         }
 
         inline std::size_t selectNoCtzll(uint64_t filterSegment, uint64_t miniBucketSegmentIndex) const {
-            return _pdep_u64(1ull << miniBucketSegmentIndex, filterSegment);
+            return selectBit<Select>(filterSegment, miniBucketSegmentIndex);
         }
 
         inline std::size_t getKeyMask(uint64_t filterSegment, uint64_t miniBucketSegmentIndex) const {
             return selectNoCtzll(filterSegment, miniBucketSegmentIndex) >> miniBucketSegmentIndex;
         }
 
+        //getKeyIndex over the two words {segment0, segment1}. Which word a random mini bucket lands in is a coin flip near the middle of the filter, so the word is picked with a mask rather than a branch (GCC turns the equivalent ternaries back into branches)
+        inline std::size_t getKeyIndex128(uint64_t segment0, uint64_t segment1, uint64_t miniBucketSegmentIndex) const {
+            uint64_t segment0Count = __builtin_popcountll(segment0);
+            uint64_t inSegment1Mask = -static_cast<uint64_t>(miniBucketSegmentIndex >= segment0Count);
+            uint64_t segment = segment0 ^ ((segment0 ^ segment1) & inSegment1Mask);
+            uint64_t segmentIndex = miniBucketSegmentIndex - (segment0Count & inSegment1Mask);
+            return select(segment, segmentIndex) + (inSegment1Mask & 64) - miniBucketSegmentIndex;
+        }
+
+        //Both bounds of a mini bucket in the two word case without branching on miniBucketIndex. The lower bound comes from the same filter shifted up a bit with a separator put in front, so mini bucket 0 needs no special case: the separator ending mini bucket i-1 becomes the i-th set bit, one position higher.
+        //The shift drops the last bit of segment1, but that is never the separator ending a mini bucket before the last one, so no lower bound needs it.
+        inline std::pair<std::size_t, std::size_t> queryMiniBucketBounds128(uint64_t segment0, uint64_t segment1, std::size_t miniBucketIndex) const {
+            uint64_t shiftedSegment0 = (segment0 << 1) | 1;
+            uint64_t shiftedSegment1 = (segment1 << 1) | (segment0 >> 63);
+            return std::make_pair(getKeyIndex128(shiftedSegment0, shiftedSegment1, miniBucketIndex), getKeyIndex128(segment0, segment1, miniBucketIndex));
+        }
+
+        //getKeyIndex over every word, for filters of more than two words. A mini bucket is in the word whose running popcount first passes its index, and with at most four words a loop is fine
+        inline std::size_t getKeyIndexMultiword(const std::array<std::uint64_t, NumUllongs>& segments, uint64_t miniBucketSegmentIndex) const {
+            uint64_t segmentIndex = miniBucketSegmentIndex;
+            std::size_t i = 0;
+            for(; i < NumUllongs-1; i++) {
+                uint64_t count = __builtin_popcountll(segments[i]);
+                if(segmentIndex < count) break;
+                segmentIndex -= count;
+            }
+            return select(segments[i], segmentIndex) + i*64 - miniBucketSegmentIndex;
+        }
+
+        inline std::array<std::uint64_t, NumUllongs> getSegments() const {
+            std::array<std::uint64_t, NumUllongs> segments;
+            for(std::size_t i{0}; i < NumUllongs; i++) {
+                segments[i] = getSegment(i);
+            }
+            return segments;
+        }
+
+        inline std::pair<std::size_t, std::size_t> queryMiniBucketBoundsMultiword(std::size_t miniBucketIndex) const {
+            std::array<std::uint64_t, NumUllongs> segments = getSegments();
+            std::size_t end = getKeyIndexMultiword(segments, miniBucketIndex);
+            return std::make_pair(miniBucketIndex == 0 ? 0 : getKeyIndexMultiword(segments, miniBucketIndex-1), end);
+        }
+
         inline std::pair<std::uint64_t, std::uint64_t> queryMiniBucketBoundsMask(std::size_t miniBucketIndex) {
-            uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
                 if(miniBucketIndex == 0) {
-                    return std::make_pair(1, getKeyMask(*fastCastFilter, miniBucketIndex));
+                    return std::make_pair(1, getKeyMask(segment0, miniBucketIndex));
                 }
                 else {
-                    return std::make_pair(getKeyMask(*fastCastFilter, miniBucketIndex-1), getKeyMask(*fastCastFilter, miniBucketIndex));
+                    return std::make_pair(getKeyMask(segment0, miniBucketIndex-1), getKeyMask(segment0, miniBucketIndex));
                 }
             }
-            else if (NumBytes <= 16 && NumKeys < 64) { //A bit sus implementation for now but should work?
-                uint64_t segmentMiniBucketCount = __builtin_popcountll(*fastCastFilter);
-                if(miniBucketIndex == 0) {
-                    return std::make_pair(1, getKeyMask(*fastCastFilter, miniBucketIndex));
-                }
-                else if (miniBucketIndex < segmentMiniBucketCount) {
-                    return std::make_pair(getKeyMask(*fastCastFilter, miniBucketIndex-1), getKeyMask(*fastCastFilter, miniBucketIndex));
-                }
-                else if (miniBucketIndex == segmentMiniBucketCount) {
-                    return std::make_pair(getKeyMask(*fastCastFilter, miniBucketIndex-1), (getKeyMask(*(fastCastFilter+1), miniBucketIndex - segmentMiniBucketCount) << (64 - segmentMiniBucketCount)));
-                }
-                else {
-                    return std::make_pair(getKeyMask(*(fastCastFilter+1), miniBucketIndex-segmentMiniBucketCount-1) << (64 - segmentMiniBucketCount), getKeyMask(*(fastCastFilter+1), miniBucketIndex - segmentMiniBucketCount) << (64 - segmentMiniBucketCount));
-                }
+            else if (NumBytes <= 16 && NumKeys < 64) {
+                std::pair<std::size_t, std::size_t> bounds = queryMiniBucketBounds128(segment0, getSegment(1), miniBucketIndex);
+                return std::make_pair(1ull << bounds.first, 1ull << bounds.second);
+            }
+            else {
+                std::pair<std::size_t, std::size_t> bounds = queryMiniBucketBoundsMultiword(miniBucketIndex);
+                return std::make_pair(1ull << bounds.first, 1ull << bounds.second);
             }
         }
 
         //Returns a pair representing [start, end) of the minibucket. So basically miniBucketIndex to keyIndex conversion
         inline std::pair<std::size_t, std::size_t> queryMiniBucketBounds(std::size_t miniBucketIndex) {
-            uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
                 if(miniBucketIndex == 0) {
-                    return std::make_pair(0, getKeyIndex(*fastCastFilter, miniBucketIndex));
+                    return std::make_pair(0, getKeyIndex(segment0, miniBucketIndex));
                 }
                 else {
-                    return std::make_pair(getKeyIndex(*fastCastFilter, miniBucketIndex-1), getKeyIndex(*fastCastFilter, miniBucketIndex));
+                    return std::make_pair(getKeyIndex(segment0, miniBucketIndex-1), getKeyIndex(segment0, miniBucketIndex));
                 }
             }
-            else if (NumBytes <= 16 && NumKeys < 64) { //A bit sus implementation for now but should work?
-                uint64_t segmentMiniBucketCount = __builtin_popcountll(*fastCastFilter);
-                if(miniBucketIndex == 0) {
-                    return std::make_pair(0, getKeyIndex(*fastCastFilter, miniBucketIndex));
-                }
-                else if (miniBucketIndex < segmentMiniBucketCount) {
-                    return std::make_pair(getKeyIndex(*fastCastFilter, miniBucketIndex-1), getKeyIndex(*fastCastFilter, miniBucketIndex));
-                }
-                else if (miniBucketIndex == segmentMiniBucketCount) {
-                    return std::make_pair(getKeyIndex(*fastCastFilter, miniBucketIndex-1), getKeyIndex(*(fastCastFilter+1), miniBucketIndex-segmentMiniBucketCount) + 64 - segmentMiniBucketCount);
-                }
-                else {
-                    return std::make_pair(getKeyIndex(*(fastCastFilter+1), miniBucketIndex-segmentMiniBucketCount-1) + 64 - segmentMiniBucketCount, getKeyIndex(*(fastCastFilter+1), miniBucketIndex-segmentMiniBucketCount) + 64 - segmentMiniBucketCount);
-                }
+            else if (NumBytes <= 16 && NumKeys < 64) {
+                return queryMiniBucketBounds128(segment0, getSegment(1), miniBucketIndex);
+            }
+            else {
+                return queryMiniBucketBoundsMultiword(miniBucketIndex);
             }
         }
 
         //Tells you which mini bucket a key belongs to. Really works same as queryMniBucketBeginning but just does bit inverse of fastCastFilter. Returns a number larger than the number of miniBuckets if keyIndex is nonexistent (should be--test this)
         inline std::size_t queryWhichMiniBucket(std::size_t keyIndex) const {
-            const uint64_t* fastCastFilter = reinterpret_cast<const uint64_t*> (&filterBytes);
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
-                return getKeyIndex(~(*fastCastFilter), keyIndex);
+                return getKeyIndex(~segment0, keyIndex);
             }
             else if (NumBytes <= 16) {
-                std::uint64_t invFilterSegment = ~(*fastCastFilter);
-                std::uint64_t segmentKeyCount = __builtin_popcountll(invFilterSegment);
-                if (keyIndex < segmentKeyCount) {
-                    return getKeyIndex(invFilterSegment, keyIndex);
-                }
-                else {
-                    invFilterSegment = ~(*(fastCastFilter+1));
-                    return getKeyIndex(invFilterSegment, keyIndex-segmentKeyCount) + 64 - segmentKeyCount;
+                return getKeyIndex128(~segment0, ~getSegment(1), keyIndex);
+            }
+            else {
+                std::array<std::uint64_t, NumUllongs> inverseSegments = getSegments();
+                for(std::uint64_t& segment: inverseSegments) {
+                    segment = ~segment;
                 }
+                return getKeyIndexMultiword(inverseSegments, keyIndex);
             }
         }
 
@@ -189,106 +229,109 @@ namespace PQF {
             if(miniBucketIndex == 0) {
                 return 0;
             }
-            uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
-                return getKeyIndex(*fastCastFilter, miniBucketIndex-1);
+                return getKeyIndex(segment0, miniBucketIndex-1);
             }
-            else if (NumBytes <= 16) { //The code below should be expanded to this but I'm doing this to be safe. Obviously these if statements need somehow to go if we wanna optimize?
-                uint64_t segmentMiniBucketCount = __builtin_popcountll(*fastCastFilter);
-                if (miniBucketIndex <= segmentMiniBucketCount) {
-                    return getKeyIndex(*fastCastFilter, miniBucketIndex-1);
-                }
-                else {
-                    return getKeyIndex(*(fastCastFilter+1), miniBucketIndex-segmentMiniBucketCount-1) + 64 - segmentMiniBucketCount;
-                }
+            else if (NumBytes <= 16) {
+                return getKeyIndex128(segment0, getSegment(1), miniBucketIndex-1);
+            }
+            else {
+                return getKeyIndexMultiword(getSegments(), miniBucketIndex-1);
             }
         }
 
-        #ifdef __AVX512BW__
-
-        //really just a "__m128i" version of ~((1ull << loc) - 1) or like -(1ull << loc)
-        inline static constexpr __m128i getShiftMask(std::size_t loc) {
-            std::array<std::uint64_t, 2> ulongs;
-            for(size_t i=0; i < 2; i++, loc-=64) {
-                if(loc >= 128) ulongs[i] = -1ull; //wrapped around so we want to set everything to zero
-                else if (loc >= 64){
-                    ulongs[i] = 0;
-                }
-                else {
-                    ulongs[i] = -(1ull << loc);
+        //Calls f(keyIndex, miniBucketIndex) for every key in the filter in order. Walks the zero bits directly rather than doing a select per key, since a key's mini bucket is just its bit position minus its key index.
+        //Stops at the first unallocated key (those sit after the last mini bucket separator)
+        template<typename F>
+        inline void forEachKey(F&& f) const {
+            std::size_t keyIndex = 0;
+            for(std::size_t i{0}; i < NumUllongs; i++) {
+                uint64_t keyBits = ~getSegment(i);
+                if(i == NumUllongs-1) keyBits &= lastSegmentMask;
+                for(; keyBits != 0; keyBits &= keyBits-1, keyIndex++) {
+                    std::size_t miniBucketIndex = i*64 + __builtin_ctzll(keyBits) - keyIndex;
+                    if(miniBucketIndex >= NumMiniBuckets) return;
+                    f(keyIndex, miniBucketIndex);
                 }
             }
-            ulongs[1] &= lastSegmentMask;
-            return std::bit_cast<__m128i>(ulongs);
         }
 
-        inline static constexpr std::array<m128iWrapper, 128> getShiftMasks() {
-            std::array<m128iWrapper, 128> masks;
-            for(size_t i = 0; i < 128; i++) {
-                masks[i] = getShiftMask(i);
+        //remove for filters of more than two words: every filter bit past index moves down one, pulling in the lowest bit of the next word, and the last filter bit becomes a key. Bits past the filter (the lock bit, and the bytes of the remainder store read along with the last word) stay put
+        inline void removeMultiword(std::size_t index) {
+            std::uint64_t segment = getSegment(0);
+            for(std::size_t i{0}; i < NumUllongs; i++) {
+                std::uint64_t nextSegment = i+1 < NumUllongs ? getSegment(i+1) : 0;
+                if(index < (i+1)*64) {
+                    std::uint64_t shiftMask = index > i*64 ? -(1ull << (index - i*64)) : -1ull;
+                    if(i == NumUllongs-1) shiftMask &= lastSegmentMask;
+                    std::uint64_t shiftedSegment = (segment >> 1) | (nextSegment << 63);
+                    std::uint64_t newSegment = (segment & ~shiftMask) | (shiftedSegment & shiftMask);
+                    if(i == NumUllongs-1) newSegment &= ~lastBitMask;
+                    setSegment(i, newSegment);
+                }
+                segment = nextSegment;
             }
-            return masks;
         }
 
-        static constexpr std::array<m128iWrapper, 128> ShiftMasks = getShiftMasks();
+        #if PQF_AVX512
 
-        inline static constexpr __m128i getZeroMask(std::size_t loc) {
-            std::array<std::uint64_t, 2> ulongs;
-            for(size_t i=0; i < 2; i++, loc-=64) {
-                if(loc >= 64) ulongs[i] = -1ull; //funny that this works even when loc "wraps around" and becomes massive cause its unsigned
-                else {
-                    ulongs[i] = ~(1ull << loc);
-                }
-            }
-            return std::bit_cast<__m128i>(ulongs);
+        //Both masks are built from the index in registers rather than loaded from a table per instantiation. Lane 0 gets shifted by loc and lane 1 by loc-64; vpsllvq gives 0 for counts of 64 or more, which the wrapped around count of lane 1 is when loc < 64.
+        inline static __m128i getShiftCounts(std::size_t loc) {
+            static constexpr __m128i laneOffsets = {0, 64};
+            return _mm_sub_epi64(_mm_set1_epi64x(loc), laneOffsets);
         }
 
-        inline static constexpr std::array<m128iWrapper, 128> getZeroMasks() {
-            std::array<m128iWrapper, 128> masks;
-            for(size_t i = 0; i < 128; i++) {
-                masks[i] = getZeroMask(i);
-            }
-            return masks;
+        //A "__m128i" version of ~((1ull << loc) - 1) or like -(1ull << loc), limited to the filter bits
+        inline static __m128i getShiftMask(std::size_t loc) {
+            static constexpr __m128i filterBitsMask = {-1ll, (long long)lastSegmentMask};
+            __m128i nonNegativeShiftCounts = _mm_max_epi64(getShiftCounts(loc), _mm_setzero_si128());
+            return _mm_and_si128(_mm_sllv_epi64(_mm_set1_epi64x(-1ll), nonNegativeShiftCounts), filterBitsMask);
+        }
+
+        //A "__m128i" version of 1ull << loc
+        inline static __m128i getBitMask(std::size_t loc) {
+            return _mm_sllv_epi64(_mm_set1_epi64x(1), getShiftCounts(loc));
         }
 
-        static constexpr std::array<m128iWrapper, 128> ZeroMasks = getZeroMasks();
+        static constexpr __m128i EmptyPatternVec = std::bit_cast<__m128i>(std::array<std::uint64_t, 2>{EmptyPattern[0], EmptyPattern[1]});
 
         //Vectorize as in the 4 bit remainder store? Probably not needed for if fits in 64 bits, so have a constexpr there.
         //Probably not the most efficient implementation, but this one is at least somewhatish straightforward. Still not great and maybe not even correct
         inline bool shiftFilterBits(std::size_t in) {
             int64_t index = in;
-            uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
             std::size_t endIndex = NumBits;
             uint64_t oldCarryBit = 0;
             uint64_t carryBit = 0;
             if constexpr (NumBytes > 8 && NumBytes <= 16) {
                 // carryBit = *(fastCastFilter+1) && (1ull << (NumBits-64)); //Why does this single line make the code FIVE TIMES slower? From 3 secs to 15?
                 __m128i* castedFilterAddress = reinterpret_cast<__m128i*>(&filterBytes);
-                __m128i filterVec = _mm_loadu_si128(castedFilterAddress);
+                __m128i filterVec = _mm_xor_si128(_mm_loadu_si128(castedFilterAddress), EmptyPatternVec);
                 static constexpr __m128i extractCarryBit = {0, (NumBits-65) << 56};
                 carryBit = _mm_bitshuffle_epi64_mask(filterVec, extractCarryBit) >> 15;
                 __m128i filterVecShiftedLeftByLong = _mm_bslli_si128(filterVec, 8);
                 __m128i shiftedFilterVec = _mm_shldi_epi64(filterVec, filterVecShiftedLeftByLong, 1);
-                filterVec = _mm_ternarylogic_epi32(filterVec, shiftedFilterVec, ShiftMasks[in], 0b11011000);
-                filterVec = _mm_and_si128(filterVec, ZeroMasks[in]); //ensuring the new bit 
-                _mm_storeu_si128(castedFilterAddress, filterVec);
+                filterVec = _mm_ternarylogic_epi32(filterVec, shiftedFilterVec, getShiftMask(in), 0b11011000);
+                filterVec = _mm_andnot_si128(getBitMask(in), filterVec); //ensuring the new bit 
+                _mm_storeu_si128(castedFilterAddress, _mm_xor_si128(filterVec, EmptyPatternVec));
             }
             else { //TODO: remove this else statement & just support it for NumBytes <= 8 with like two lines of code. Probably wouldn't be any (or at least much) faster really, but would simplify code
-                for(size_t i{0}; i < NumUllongs; i++, fastCastFilter++, index-=64, endIndex-=64) {
+                for(size_t i{0}; i < NumUllongs; i++, index-=64, endIndex-=64) {
                     std::size_t segmentStartIndex = std::max((long long)index, 0ll);
                     if(segmentStartIndex >= 64) continue;
                     uint64_t shiftBitIndex = 1ull << segmentStartIndex;
                     uint64_t shiftMask = -(shiftBitIndex);
-                    uint64_t shiftedSegment = ((*fastCastFilter) & shiftMask) << 1;
+                    uint64_t segment = getSegment(i);
+                    uint64_t shiftedSegment = (segment & shiftMask) << 1;
                     if(endIndex < 64) {
                         shiftMask &= (1ull << endIndex) - 1;
-                        carryBit = (*fastCastFilter) & (1ull << (endIndex-1));
+                        carryBit = segment & (1ull << (endIndex-1));
                     }
                     else {
-                        carryBit = (*fastCastFilter) & (1ull << 63);
+                        carryBit = segment & (1ull << 63);
                     }
                     carryBit = carryBit != 0;
-                    *fastCastFilter = (*fastCastFilter & (~shiftMask)) | (shiftedSegment & shiftMask) | (oldCarryBit << segmentStartIndex);
+                    setSegment(i, (segment & (~shiftMask)) | (shiftedSegment & shiftMask) | (oldCarryBit << segmentStartIndex));
                     oldCarryBit = carryBit;
                 }
             }
@@ -299,20 +342,24 @@ namespace PQF {
         inline void remove(std::size_t miniBucketIndex, std::size_t keyIndex) {
             std::size_t index = miniBucketIndex + keyIndex;
             if constexpr (NumBytes <= 8){
-                uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
+                uint64_t segment = getSegment(0);
                 uint64_t shiftBitIndex = 1ull << index;
                 uint64_t shiftMask = (-(shiftBitIndex)) & lastSegmentMask;
-                uint64_t shiftedSegment = ((*fastCastFilter) & shiftMask) >> 1;
-                *fastCastFilter = (*fastCastFilter & (~shiftMask)) | (shiftedSegment & shiftMask);
+                uint64_t shiftedSegment = (segment & shiftMask) >> 1;
+                setSegment(0, (segment & (~shiftMask)) | (shiftedSegment & shiftMask));
             }
             else if (NumBytes > 8 && NumBytes <= 16) {
                 __m128i* castedFilterAddress = reinterpret_cast<__m128i*>(&filterBytes);
-                __m128i filterVec = _mm_loadu_si128(castedFilterAddress);
+                __m128i filterVec = _mm_xor_si128(_mm_loadu_si128(castedFilterAddress), EmptyPatternVec);
                 __m128i filterVecShiftedRightByLong = _mm_bsrli_si128(filterVec, 8);
                 __m128i shiftedFilterVec = _mm_shrdi_epi64(filterVec, filterVecShiftedRightByLong, 1);
-                filterVec = _mm_ternarylogic_epi32(filterVec, shiftedFilterVec, ShiftMasks[index], 0b11011000);
-                filterVec = _mm_and_si128(filterVec, ZeroMasks[NumBits-1]); //Ensuring we are zeroing out the bit we just added, as we assume the person is removing a key, not a bucket (as that would make no sense)
-                _mm_storeu_si128(castedFilterAddress, filterVec);
+                static constexpr __m128i lastBitZeroMask = {-1ll, (long long)~lastBitMask};
+                filterVec = _mm_ternarylogic_epi32(filterVec, shiftedFilterVec, getShiftMask(index), 0b11011000);
+                filterVec = _mm_and_si128(filterVec, lastBitZeroMask); //Ensuring we are zeroing out the bit we just added, as we assume the person is removing a key, not a bucket (as that would make no sense)
+                _mm_storeu_si128(castedFilterAddress, _mm_xor_si128(filterVec, EmptyPatternVec));
+            }
+            else {
+                removeMultiword(index);
             }
         }
 
@@ -321,26 +368,26 @@ namespace PQF {
         inline bool shiftFilterBits(std::size_t in) {
             // std::cout << "shifting" << std::endl;
             int64_t index = in;
-            uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
             std::size_t endIndex = NumBits;
             uint64_t oldCarryBit = 0;
             uint64_t carryBit = 0;
             // thankfully didn't remove this loop, hehe
-            for(size_t i{0}; i < NumUllongs; i++, fastCastFilter++, index-=64, endIndex-=64) {
+            for(size_t i{0}; i < NumUllongs; i++, index-=64, endIndex-=64) {
                 std::size_t segmentStartIndex = std::max((long long)index, 0ll);
                 if(segmentStartIndex >= 64) continue;
                 uint64_t shiftBitIndex = 1ull << segmentStartIndex;
                 uint64_t shiftMask = -(shiftBitIndex);
-                uint64_t shiftedSegment = ((*fastCastFilter) & shiftMask) << 1;
+                uint64_t segment = getSegment(i);
+                uint64_t shiftedSegment = (segment & shiftMask) << 1;
                 if(endIndex < 64) {
                     shiftMask &= (1ull << endIndex) - 1;
-                    carryBit = (*fastCastFilter) & (1ull << (endIndex-1));
+                    carryBit = segment & (1ull << (endIndex-1));
                 }
                 else {
-                    carryBit = (*fastCastFilter) & (1ull << 63);
+                    carryBit = segment & (1ull << 63);
                 }
                 carryBit = carryBit != 0;
-                *fastCastFilter = (*fastCastFilter & (~shiftMask)) | (shiftedSegment & shiftMask) | (oldCarryBit << segmentStartIndex);
+                setSegment(i, (segment & (~shiftMask)) | (shiftedSegment & shiftMask) | (oldCarryBit << segmentStartIndex));
                 oldCarryBit = carryBit;
             }
 
@@ -351,11 +398,11 @@ namespace PQF {
             std::size_t index = miniBucketIndex + keyIndex;
             // std::cout << "removing at " << index << std::endl;
             if constexpr (NumBytes <= 8){
-                uint64_t* fastCastFilter = reinterpret_cast<uint64_t*> (&filterBytes);
+                uint64_t segment = getSegment(0);
                 uint64_t shiftBitIndex = 1ull << index;
                 uint64_t shiftMask = (-(shiftBitIndex)) & lastSegmentMask;
-                uint64_t shiftedSegment = ((*fastCastFilter) & shiftMask) >> 1;
-                *fastCastFilter = (*fastCastFilter & (~shiftMask)) | (shiftedSegment & shiftMask);
+                uint64_t shiftedSegment = (segment & shiftMask) >> 1;
+                setSegment(0, (segment & (~shiftMask)) | (shiftedSegment & shiftMask));
             }
             else if (NumBytes > 8 && NumBytes <= 16) {
                 uint64_t temp[2] = {0, 0};
@@ -363,17 +410,28 @@ namespace PQF {
                 // printBinaryUInt64(*(uint64_t*)(&filterBytes[8]), true);
                 size_t offset = (index >= 64) * 8;
                 std::memcpy(temp, &filterBytes[0] + offset, NumBytes - offset);
+                temp[0] ^= EmptyPattern[offset/8];
+                temp[1] ^= EmptyPattern[offset/8 + 1];
+                //Only the filter bits move, like the masks do in the AVX512 version: the bits past the filter (the lock bit when Threaded, which is set while we remove) stay put, and the last filter bit becomes a key
+                std::uint64_t& lastSegment = temp[NumUllongs - 1 - offset/8];
+                std::uint64_t bitsPastFilter = lastSegment & ~lastSegmentMask;
                 
                 uint64_t shiftBitIndex = 1ull << (index % 64);
                 uint64_t shiftMask = (-(shiftBitIndex));
                 uint64_t shiftedSegment = ((temp[0] & shiftMask) >> 1) | (temp[1] << 63ull);
                 temp[0] = (temp[0] & (~shiftMask)) | (shiftedSegment & shiftMask);
                 temp[1] >>= 1;
+                lastSegment = (lastSegment & (lastSegmentMask >> 1)) | bitsPastFilter;
+                temp[0] ^= EmptyPattern[offset/8];
+                temp[1] ^= EmptyPattern[offset/8 + 1];
 
                 std::memcpy(&filterBytes[0] + offset, temp, NumBytes - offset);
                 // printBinaryUInt64(*(uint64_t*)(&filterBytes[0]), true);
                 // printBinaryUInt64(*(uint64_t*)(&filterBytes[8]), true);
             }
+            else {
+                removeMultiword(index);
+            }
         }
 
         #endif
@@ -382,26 +440,35 @@ namespace PQF {
         //TODO: specialize it for just up to two ullongs to simplify the code (& possibly small speedup but probably not)
         //Keys are zeros, so "fix overflow" basically makes it so  that we overflow the key, not the mini bucket. We essentially aim to replace the last zero with a one
         inline uint64_t fixOverflow() {
-            uint64_t* fastCastFilter = (reinterpret_cast<uint64_t*> (&filterBytes)) + NumUllongs-1;
-            uint64_t lastSegmentInverse = (~(*fastCastFilter)) & lastSegmentMask;
+            std::size_t segmentIndex = NumUllongs-1;
+            uint64_t segment = getSegment(segmentIndex);
+            uint64_t lastSegmentInverse = (~segment) & lastSegmentMask;
             uint64_t offsetMiniBuckets = NumBits-(NumUllongs-1)*64; //Again bad name. We want to return the mini bucket index, and to do that we are counting how many mini buckets from the end we have. Originally had this be popcount, but we don't need popcount, since we only continue if everything is ones basically!
             if (lastSegmentInverse != 0) {
-                size_t skipMiniBuckets = _lzcnt_u64(lastSegmentInverse); //get a better name oops
-                *fastCastFilter = (*fastCastFilter) | (1ull << (63-skipMiniBuckets));
+                size_t skipMiniBuckets = std::countl_zero(lastSegmentInverse); //get a better name oops
+                setSegment(segmentIndex, segment | (1ull << (63-skipMiniBuckets)));
                 return NumMiniBuckets-(skipMiniBuckets - 64 + offsetMiniBuckets)-1;
             }
-            fastCastFilter--;
-            if constexpr (DEBUG)
-                assert(fastCastFilter >= reinterpret_cast<uint64_t*> (&filterBytes));
-            uint64_t segmentInverse = ~(*fastCastFilter); //This gives a warning in -O2 cause it may be out of bounds even though I assert it never happens!
-            for(; segmentInverse == 0; offsetMiniBuckets += 64, fastCastFilter--) {
+            if constexpr (NumUllongs == 1) {
+                //A full filter has its key zeros in its one segment, so the last zero was found above
+                return -1ull;
+            }
+            else {
+                segmentIndex--;
+                segment = getSegment(segmentIndex);
+                uint64_t segmentInverse = ~segment;
+                while(segmentInverse == 0 && segmentIndex > 0) { //Only ever loops with more than two words
+                    offsetMiniBuckets += 64;
+                    segmentIndex--;
+                    segment = getSegment(segmentIndex);
+                    segmentInverse = ~segment;
+                }
                 if constexpr (DEBUG)
-                    assert(fastCastFilter >= reinterpret_cast<uint64_t*> (&filterBytes));
-                segmentInverse = ~(*fastCastFilter);
+                    assert(segmentInverse != 0);
+                size_t skipMiniBuckets = std::countl_zero(segmentInverse);
+                setSegment(segmentIndex, segment | (1ull << (63-skipMiniBuckets)));
+                return NumMiniBuckets-skipMiniBuckets-offsetMiniBuckets-1;
             }
-            size_t skipMiniBuckets = _lzcnt_u64(segmentInverse);
-            *fastCastFilter = (*fastCastFilter) | (1ull << (63-skipMiniBuckets));
-            return NumMiniBuckets-skipMiniBuckets-offsetMiniBuckets-1;
         }
         
         //Returns true if the filter was full and had to kick somebody to make room.
@@ -426,30 +493,28 @@ namespace PQF {
         //Maybe remove the for loop & specialize it for <= 2 ullongs
         //We implement this by counting where the last bucket cutoff is, and then the number of keys is just that minus the number of buckets. So p similar to fixOverflow()
         inline std::size_t countKeys() {
-            uint64_t* fastCastFilter = (reinterpret_cast<uint64_t*> (&filterBytes)) + NumUllongs-1;
-            uint64_t segment = (*fastCastFilter) & lastSegmentMask;
+            std::size_t segmentIndex = NumUllongs-1;
+            uint64_t segment = getSegment(segmentIndex) & lastSegmentMask;
             size_t offset = (NumUllongs-1) * 64;
-            for(; segment == 0; fastCastFilter--, segment = *fastCastFilter, offset -= 64);
-            if constexpr (DEBUG) {
-                if (!(fastCastFilter >= (reinterpret_cast<uint64_t*> (&filterBytes)))) {
-                    std::cout << *(reinterpret_cast<uint64_t*> (&filterBytes)) << " " << *((reinterpret_cast<uint64_t*> (&filterBytes)) + NumUllongs-1) << " cccvc " << (NumUllongs -1) << std::endl;
+            for(; segment == 0; segmentIndex--, segment = getSegment(segmentIndex), offset -= 64) {
+                if constexpr (DEBUG) {
+                    assert(segmentIndex > 0);
                 }
-                assert(fastCastFilter >= (reinterpret_cast<uint64_t*> (&filterBytes)));
             }
-            return (64 - _lzcnt_u64(segment)) + offset - NumMiniBuckets;
+            return (64 - std::countl_zero(segment)) + offset - NumMiniBuckets;
         }
 
         //Tells you if a mini bucket is at the very "end" of a filter. Basically, the point is to tell you if you need to go to the backyard.
         inline bool miniBucketOutofFilterBounds(std::size_t miniBucket) {
-            uint64_t* fastCastFilter = (reinterpret_cast<uint64_t*> (&filterBytes));
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
                 std::size_t previousElementsMask = ((((-1ull)<<NumKeys) << miniBucket)) & lastSegmentMask;
-                return ((*fastCastFilter) & lastSegmentMask) >= previousElementsMask;
+                return (segment0 & lastSegmentMask) >= previousElementsMask;
             }
             else if (NumBytes <= 16) {
                 if (NumKeys + miniBucket >= 64) {
                     std::size_t previousElementsMask = (((-1ull)<<(NumKeys + miniBucket - 64))) & lastSegmentMask;
-                    return ((*(fastCastFilter+1)) & lastSegmentMask) >= previousElementsMask;
+                    return (getSegment(1) & lastSegmentMask) >= previousElementsMask;
                 }
                 else {
                     return false; //Technically wrong but we'll say that it is very unlikely. However maybe need to fix this!!
@@ -459,11 +524,11 @@ namespace PQF {
         }
 
         inline std::size_t checkMiniBucketKeyPair(std::size_t miniBucket, std::size_t keyBit) {
-            uint64_t* fastCastFilter = (reinterpret_cast<uint64_t*> (&filterBytes));
+            const uint64_t segment0 = getSegment(0);
             if constexpr (NumBytes <= 8) {
                 std::size_t keyBucketLoc = keyBit << miniBucket;
-                std::size_t pcnt = __builtin_popcountll((keyBucketLoc-1) & (*fastCastFilter));
-                if (pcnt == miniBucket && (keyBucketLoc & (*fastCastFilter)) == 0) {
+                std::size_t pcnt = __builtin_popcountll((keyBucketLoc-1) & segment0);
+                if (pcnt == miniBucket && (keyBucketLoc & segment0) == 0) {
                     return 1;
                 }
                 else {
@@ -493,8 +558,9 @@ namespace PQF {
             int64_t bitsNeedToSet = miniBucketIndex+keyIndex;
             int64_t bitsLeftInFilter = NumBits;
             size_t lastZeroPos = -1;
+            std::array<uint8_t, NumBytes> decodedFilterBytes = decodedBytes();
             for(std::size_t i{0}; i < NumBytes; i++) {
-                uint8_t byte = filterBytes[i];
+                uint8_t byte = decodedFilterBytes[i];
                 uint8_t shiftedByte = 0;
                 for(int64_t j{0}; j < 8 && j < bitsLeftInFilter; j++, byte >>= 1, bitsNeedToSet--) {
                     if(bitsNeedToSet <= 0) {
@@ -523,7 +589,7 @@ namespace PQF {
                 *byteToChange |= 1 << lastZeroPos;
             }
             std::uint64_t overflow = insert(miniBucketIndex, keyIndex);
-            assert(expectedFilterBytes == filterBytes);
+            assert(expectedFilterBytes == decodedBytes());
             assert((overflow != -1ull) == expectedOverflow.has_value());
             if((overflow != -1ull)) {
                 assert(overflow == *expectedOverflow);
@@ -533,12 +599,13 @@ namespace PQF {
 
         void checkCorrectPopCount() {
             uint64_t totalPopcount = 0;
-            for(uint8_t byte: filterBytes) {
+            for(uint8_t byte: decodedBytes()) {
                 totalPopcount += __builtin_popcountll(byte);
             }
             assert(totalPopcount == NumMiniBuckets);
         }
     };
 }
+}
 
 #endif
\ No newline at end of file
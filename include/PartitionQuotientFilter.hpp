@@ -9,11 +9,20 @@
 #include <vector>
 #include <set>
 #include <random>
+#include <thread>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
 #include "Bucket.hpp"
 #include "QRContainers.hpp"
 #include "RemainderStore.hpp"
 
 namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
 
     template<typename T, size_t alignment>
     class AlignedVector { //Just here to make locking easier, lol
@@ -26,28 +35,65 @@ namespace PQF {
                 return ((num*sizeof(T)+alignment - 1) / alignment)*alignment;
             }
 
+            //Empty buckets are all zero bytes, so large vectors are just mapped anonymous memory. Construction is then O(1), and pages are only faulted in once something gets written to them.
+            static constexpr size_t MmapThreshold = 1ull << 20;
+
+            static bool emptyIsZero() {
+                static const bool isZero = [] {
+                    T empty = T();
+                    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&empty);
+                    return std::all_of(bytes, bytes + sizeof(T), [](unsigned char b) {return b == 0;});
+                }();
+                return isZero;
+            }
+
+            bool usesMmap() const {
+                return alignedSize >= MmapThreshold && emptyIsZero();
+            }
+
+            T* allocate() {
+                if(usesMmap()) {
+                    void* mem = mmap(NULL, alignedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if(mem == MAP_FAILED) {
+                        throw std::bad_alloc();
+                    }
+                    return static_cast<T*>(mem);
+                }
+                return static_cast<T*>(std::aligned_alloc(alignment, alignedSize));
+            }
+
+            void deallocate() {
+                if(vec == NULL) return;
+                if(usesMmap()) {
+                    munmap(vec, alignedSize);
+                }
+                else {
+                    free(vec);
+                }
+            }
+
         public:
-            AlignedVector(std::size_t s=0): s{s}, alignedSize{getAlignedSize(s)}, vec{static_cast<T*>(std::aligned_alloc(alignment, alignedSize))} {
-                for(size_t i{0}; i < s; i++) {
-                    vec[i] = T();
+            AlignedVector(std::size_t s=0): s{s}, alignedSize{getAlignedSize(s)}, vec{allocate()} {
+                if(!usesMmap()) {
+                    clear();
                 }
             }
             ~AlignedVector() {
-                if(vec != NULL)
-                    free(vec);
+                deallocate();
             }
 
-            AlignedVector(const AlignedVector& a): s{a.s}, alignedSize{getAlignedSize(s)}, vec{static_cast<T*>(std::aligned_alloc(alignment, alignedSize))} {
+            AlignedVector(const AlignedVector& a): s{a.s}, alignedSize{getAlignedSize(s)}, vec{allocate()} {
                 memcpy(vec, a.vec, alignedSize);
             }
 
             AlignedVector& operator=(const AlignedVector& a) {
-                if(vec!=NULL)
-                    free(vec);
-                s = a.s;
-                alignedSize = a.alignedSize;
-                vec = static_cast<T*>(std::aligned_alloc(alignment, alignedSize));
-                memcpy(vec, a.vec, alignedSize);
+                if(this != &a) {
+                    deallocate();
+                    s = a.s;
+                    alignedSize = a.alignedSize;
+                    vec = allocate();
+                    memcpy(vec, a.vec, alignedSize);
+                }
                 return *this;
             }
 
@@ -58,12 +104,15 @@ namespace PQF {
             }
 
             AlignedVector& operator=(AlignedVector&& a) {
-                vec = a.vec;
-                s = a.s;
-                alignedSize = a.alignedSize;
-                a.s = 0;
-                a.alignedSize = 0;
-                a.vec = NULL;
+                if(this != &a) {
+                    deallocate();
+                    vec = a.vec;
+                    s = a.s;
+                    alignedSize = a.alignedSize;
+                    a.s = 0;
+                    a.alignedSize = 0;
+                    a.vec = NULL;
+                }
                 return *this;
             }
 
@@ -78,21 +127,423 @@ namespace PQF {
             size_t size() const {
                 return s;
             }
+
+            //Mapped memory is handed back to the OS rather than zeroed by hand, so a cleared filter also gives back its memory
+            void clear() {
+                if(usesMmap()) {
+                    madvise(vec, alignedSize, MADV_DONTNEED);
+                }
+                else if(emptyIsZero()) {
+                    //emptyIsZero() means an empty T is all zero bytes, so zeroing the memory is the same as assigning T() to each element
+                    memset(static_cast<void*>(vec), 0, alignedSize);
+                }
+                else {
+                    for(size_t i{0}; i < s; i++) {
+                        vec[i] = T();
+                    }
+                }
+            }
+
+            //Always allocated, so these only exist to share an interface with LazyAlignedVector
+            void materialize(size_t) {}
+
+            bool isMaterialized(size_t) const {
+                return true;
+            }
+
+            size_t sizeInBytes() const {
+                return s*sizeof(T);
+            }
+    };
+
+    //Same as AlignedVector, except that memory is allocated one region (a page by default) at a time, the first time that region gets written to. Until then, reads of the region see a shared empty region instead.
+    //So anything that writes to element i must call materialize(i) first. Materializing is thread safe, and clear() gives the memory back.
+    template<typename T, size_t alignment, size_t RegionBytes = 4096>
+    class LazyAlignedVector {
+        static_assert(RegionBytes % sizeof(T) == 0 && RegionBytes % alignment == 0);
+        static constexpr size_t RegionSize = RegionBytes / sizeof(T);
+
+        private:
+            std::size_t s;
+            std::size_t numRegions;
+            std::unique_ptr<std::atomic<T*>[]> regions;
+            alignas(alignment) static inline T emptyRegion[RegionSize] = {};
+
+            static T* allocateRegion() {
+                T* region = static_cast<T*>(std::aligned_alloc(alignment, RegionBytes));
+                for(size_t i{0}; i < RegionSize; i++) {
+                    region[i] = T();
+                }
+                return region;
+            }
+
+            void freeRegions() {
+                for(size_t i{0}; i < numRegions; i++) {
+                    T* region = regions[i].exchange(nullptr);
+                    if(region != nullptr)
+                        free(region);
+                }
+            }
+
+            void copyRegions(const LazyAlignedVector& a) {
+                for(size_t i{0}; i < numRegions; i++) {
+                    T* region = a.regions[i].load(std::memory_order_acquire);
+                    if(region != nullptr) {
+                        T* copy = static_cast<T*>(std::aligned_alloc(alignment, RegionBytes));
+                        memcpy(copy, region, RegionBytes);
+                        regions[i].store(copy, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+        public:
+            LazyAlignedVector(std::size_t s=0): s{s}, numRegions{(s + RegionSize - 1) / RegionSize}, regions{std::make_unique<std::atomic<T*>[]>(numRegions)} {
+                for(size_t i{0}; i < numRegions; i++) {
+                    regions[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+            ~LazyAlignedVector() {
+                if(regions)
+                    freeRegions();
+            }
+
+            LazyAlignedVector(const LazyAlignedVector& a): LazyAlignedVector(a.s) {
+                copyRegions(a);
+            }
+
+            LazyAlignedVector& operator=(const LazyAlignedVector& a) {
+                if(this != &a) {
+                    if(regions)
+                        freeRegions();
+                    s = a.s;
+                    numRegions = a.numRegions;
+                    regions = std::make_unique<std::atomic<T*>[]>(numRegions);
+                    for(size_t i{0}; i < numRegions; i++) {
+                        regions[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                    copyRegions(a);
+                }
+                return *this;
+            }
+
+            LazyAlignedVector(LazyAlignedVector&& a): s{a.s}, numRegions{a.numRegions}, regions{std::move(a.regions)} {
+                a.s = 0;
+                a.numRegions = 0;
+            }
+
+            LazyAlignedVector& operator=(LazyAlignedVector&& a) {
+                if(regions)
+                    freeRegions();
+                s = a.s;
+                numRegions = a.numRegions;
+                regions = std::move(a.regions);
+                a.s = 0;
+                a.numRegions = 0;
+                return *this;
+            }
+
+            //Only safe to write through if materialize(i) was called
+            T& operator[](size_t i) {
+                T* region = regions[i / RegionSize].load(std::memory_order_acquire);
+                return (region != nullptr ? region : emptyRegion)[i % RegionSize];
+            }
+
+            const T& operator[](size_t i) const {
+                const T* region = regions[i / RegionSize].load(std::memory_order_acquire);
+                return (region != nullptr ? region : emptyRegion)[i % RegionSize];
+            }
+
+            size_t size() const {
+                return s;
+            }
+
+            void clear() {
+                freeRegions();
+            }
+
+            void materialize(size_t i) {
+                std::atomic<T*>& region = regions[i / RegionSize];
+                if(region.load(std::memory_order_acquire) != nullptr) return;
+                T* fresh = allocateRegion();
+                T* expected = nullptr;
+                if(!region.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) { //someone else got there first
+                    free(fresh);
+                }
+            }
+
+            bool isMaterialized(size_t i) const {
+                return regions[i / RegionSize].load(std::memory_order_acquire) != nullptr;
+            }
+
+            size_t sizeInBytes() const {
+                size_t bytes = numRegions * sizeof(std::atomic<T*>);
+                for(size_t i{0}; i < numRegions; i++) {
+                    if(regions[i].load(std::memory_order_relaxed) != nullptr)
+                        bytes += RegionBytes;
+                }
+                return bytes;
+            }
+    };
+
+    //The frontyard and backyard buckets of a filter in one allocation, cut into RegionBytes regions that each hold BackyardPerRegion backyard buckets followed by FrontyardPerRegion frontyard buckets. Frontyard bucket i is in region i / FrontyardPerRegion, backyard bucket j in region j / BackyardPerRegion.
+    //Regions are aligned to their size and handed to transparent huge pages, so with the default 2MB a frontyard bucket and the backyard buckets of its region are on one page. A filter with at most FrontyardPerRegion frontyard buckets gets a single region just big enough for it, with the backyard it would have had otherwise.
+    //Indexing the frontyard gives the frontyard buckets like AlignedVector does, and backyard() gives a view of the backyard buckets with the same interface.
+    template<typename FrontyardT, typename BackyardT, std::size_t FrontyardToBackyardRatio, std::size_t RegionBytes = (1ull << 21)>
+    class InterleavedBuckets {
+        static_assert(64 % sizeof(FrontyardT) == 0 && 64 % sizeof(BackyardT) == 0);
+
+        public:
+            //Same backyard size as a filter with numFrontyardBuckets frontyard buckets and the separate layout
+            static constexpr std::size_t backyardBucketsFor(std::size_t numFrontyardBuckets) {
+                return (numFrontyardBuckets + FrontyardToBackyardRatio - 1)/FrontyardToBackyardRatio + FrontyardToBackyardRatio*2;
+            }
+
+        private:
+            static constexpr std::size_t FrontyardPerCacheline = 64 / sizeof(FrontyardT);
+            static constexpr std::size_t BackyardPerCacheline = 64 / sizeof(BackyardT);
+
+            static constexpr std::size_t roundUp(std::size_t x, std::size_t multiple) {
+                return (x + multiple - 1) / multiple * multiple;
+            }
+
+            //Most frontyard buckets a region has room for along with their backyard. Both parts are whole cachelines, so that buckets sharing a cacheline (and a lock) never straddle two regions
+            static constexpr std::pair<std::size_t, std::size_t> regionGeometry() {
+                //Every FrontyardToBackyardRatio frontyard buckets take up at least one backyard bucket, so the search starts from there
+                for(std::size_t f = RegionBytes*FrontyardToBackyardRatio / (FrontyardToBackyardRatio*sizeof(FrontyardT) + sizeof(BackyardT)) / FrontyardPerCacheline * FrontyardPerCacheline; f > 0; f -= FrontyardPerCacheline) {
+                    std::size_t b = roundUp(backyardBucketsFor(f), BackyardPerCacheline);
+                    if(f*sizeof(FrontyardT) + b*sizeof(BackyardT) <= RegionBytes) {
+                        return {f, b};
+                    }
+                }
+                return {0, 0};
+            }
+
+        public:
+            static constexpr std::size_t FrontyardPerRegion = regionGeometry().first;
+            static constexpr std::size_t BackyardPerRegion = regionGeometry().second;
+            static_assert(FrontyardPerRegion > 0);
+
+        private:
+            //Going one region further along skips over what is between the frontyards (backyards) of two consecutive regions, so bucket i is i buckets plus i / per region gaps past the first one
+            static constexpr std::size_t FrontyardGap = RegionBytes - FrontyardPerRegion*sizeof(FrontyardT);
+            static constexpr std::size_t BackyardGap = RegionBytes - BackyardPerRegion*sizeof(BackyardT);
+
+            std::size_t numFrontyard;
+            std::size_t numBackyard;
+            std::size_t frontyardOffset; //Bytes from the start of a region to its first frontyard bucket
+            std::size_t allocatedBytes;
+            std::size_t mappedBytes; //What is left mapped after trimming, when mapped
+            void* mapping;
+            char* mem;
+            char* frontyardBase;
+
+            bool usesMmap() const {
+                return numFrontyard > FrontyardPerRegion;
+            }
+
+            //Several regions get mapped memory, aligned to RegionBytes by mapping a region more than needed and unmapping the slack on both sides. Empty buckets are all zero bytes, so this is all the initialization they need
+            void allocate() {
+                if(usesMmap()) {
+                    mappedBytes = allocatedBytes + RegionBytes;
+                    mapping = mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if(mapping == MAP_FAILED) {
+                        throw std::bad_alloc();
+                    }
+                    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapping);
+                    std::uintptr_t alignedStart = roundUp(start, RegionBytes);
+                    if(alignedStart > start) {
+                        munmap(mapping, alignedStart - start);
+                    }
+                    std::size_t tail = start + mappedBytes - (alignedStart + roundUp(allocatedBytes, 4096));
+                    if(tail > 0) {
+                        munmap(reinterpret_cast<void*>(alignedStart + roundUp(allocatedBytes, 4096)), tail);
+                    }
+                    mapping = reinterpret_cast<void*>(alignedStart);
+                    mappedBytes = roundUp(allocatedBytes, 4096);
+#ifdef MADV_HUGEPAGE
+                    madvise(mapping, mappedBytes, MADV_HUGEPAGE);
+#endif
+                    mem = static_cast<char*>(mapping);
+                }
+                else {
+                    mem = static_cast<char*>(std::aligned_alloc(64, allocatedBytes));
+                    if(mem == NULL) {
+                        throw std::bad_alloc();
+                    }
+                    clear();
+                }
+                frontyardBase = mem + frontyardOffset;
+            }
+
+            void deallocate() {
+                if(mem == NULL) return;
+                if(usesMmap()) {
+                    munmap(mapping, mappedBytes);
+                }
+                else {
+                    free(mem);
+                }
+                mem = NULL;
+            }
+
+        public:
+            //A view of the backyard buckets, which only lives as long as the InterleavedBuckets it came from
+            template<bool Const>
+            class BackyardView {
+                using Storage = std::conditional_t<Const, const InterleavedBuckets, InterleavedBuckets>;
+                using Reference = std::conditional_t<Const, const BackyardT&, BackyardT&>;
+                Storage* storage;
+
+                public:
+                    BackyardView(Storage* storage): storage{storage} {}
+
+                    Reference operator[](std::size_t j) const {
+                        return *reinterpret_cast<BackyardT*>(storage->mem + j*sizeof(BackyardT) + (j / BackyardPerRegion)*BackyardGap);
+                    }
+
+                    std::size_t size() const {
+                        return storage->numBackyard;
+                    }
+
+                    //The backyard gets cleared along with the frontyard, and its size is whatever the allocation has on top of the frontyard buckets
+                    void clear() const {}
+
+                    void materialize(std::size_t) const {}
+
+                    std::size_t sizeInBytes() const {
+                        return storage->allocatedBytes - storage->numFrontyard*sizeof(FrontyardT);
+                    }
+            };
+
+            InterleavedBuckets(std::size_t numFrontyard=0): numFrontyard{numFrontyard} {
+                if(usesMmap()) {
+                    std::size_t numRegions = (numFrontyard + FrontyardPerRegion - 1) / FrontyardPerRegion;
+                    numBackyard = numRegions*BackyardPerRegion;
+                    frontyardOffset = BackyardPerRegion*sizeof(BackyardT);
+                    allocatedBytes = (numRegions-1)*RegionBytes + frontyardOffset + (numFrontyard - (numRegions-1)*FrontyardPerRegion)*sizeof(FrontyardT);
+                }
+                else {
+                    numBackyard = backyardBucketsFor(numFrontyard);
+                    frontyardOffset = roundUp(numBackyard*sizeof(BackyardT), 64);
+                    allocatedBytes = roundUp(frontyardOffset + numFrontyard*sizeof(FrontyardT), 64);
+                }
+                allocate();
+            }
+
+            ~InterleavedBuckets() {
+                deallocate();
+            }
+
+            InterleavedBuckets(const InterleavedBuckets& a): numFrontyard{a.numFrontyard}, numBackyard{a.numBackyard}, frontyardOffset{a.frontyardOffset}, allocatedBytes{a.allocatedBytes} {
+                allocate();
+                memcpy(mem, a.mem, allocatedBytes);
+            }
+
+            InterleavedBuckets& operator=(const InterleavedBuckets& a) {
+                if(this != &a) {
+                    InterleavedBuckets copy(a);
+                    *this = std::move(copy);
+                }
+                return *this;
+            }
+
+            InterleavedBuckets(InterleavedBuckets&& a): numFrontyard{a.numFrontyard}, numBackyard{a.numBackyard}, frontyardOffset{a.frontyardOffset}, allocatedBytes{a.allocatedBytes}, mappedBytes{a.mappedBytes}, mapping{a.mapping}, mem{a.mem}, frontyardBase{a.frontyardBase} {
+                a.mem = NULL;
+                a.numFrontyard = 0;
+            }
+
+            InterleavedBuckets& operator=(InterleavedBuckets&& a) {
+                if(this != &a) {
+                    deallocate();
+                    numFrontyard = a.numFrontyard;
+                    numBackyard = a.numBackyard;
+                    frontyardOffset = a.frontyardOffset;
+                    allocatedBytes = a.allocatedBytes;
+                    mappedBytes = a.mappedBytes;
+                    mapping = a.mapping;
+                    mem = a.mem;
+                    frontyardBase = a.frontyardBase;
+                    a.mem = NULL;
+                    a.numFrontyard = 0;
+                }
+                return *this;
+            }
+
+            FrontyardT& operator[](std::size_t i) {
+                return *reinterpret_cast<FrontyardT*>(frontyardBase + i*sizeof(FrontyardT) + (i / FrontyardPerRegion)*FrontyardGap);
+            }
+
+            const FrontyardT& operator[](std::size_t i) const {
+                return *reinterpret_cast<const FrontyardT*>(frontyardBase + i*sizeof(FrontyardT) + (i / FrontyardPerRegion)*FrontyardGap);
+            }
+
+            std::size_t size() const {
+                return numFrontyard;
+            }
+
+            BackyardView<false> backyard() {
+                return {this};
+            }
+
+            BackyardView<true> backyard() const {
+                return {this};
+            }
+
+            //Whether the backyard mapping has to be done region by region, rather than over the whole (single region) backyard
+            bool multipleRegions() const {
+                return usesMmap();
+            }
+
+            //Clears the backyard as well. Mapped memory is handed back to the OS rather than zeroed by hand, like in AlignedVector
+            void clear() {
+                if(usesMmap()) {
+                    madvise(mapping, mappedBytes, MADV_DONTNEED);
+                }
+                else {
+                    memset(mem, 0, allocatedBytes);
+                }
+            }
+
+            void materialize(std::size_t) {}
+
+            bool isMaterialized(std::size_t) const {
+                return true;
+            }
+
+            std::size_t sizeInBytes() const {
+                return numFrontyard*sizeof(FrontyardT);
+            }
     };
 
-    template<std::size_t SizeRemainders, std::size_t BucketNumMiniBuckets, std::size_t FrontyardBucketCapacity = 51, std::size_t BackyardBucketCapacity = 35, std::size_t FrontyardToBackyardRatio = 8, std::size_t FrontyardBucketSize = 64, std::size_t BackyardBucketSize = 64, bool FastSQuery = false, bool Threaded = false>
+    //How the frontyard and backyard buckets are laid out in memory. Separate keeps them in two arrays, and the backyard buckets a frontyard bucket overflows into can be anywhere in the backyard, so an operation that goes to the backyard can touch three pages.
+    //Interleaved keeps them in InterleavedBuckets and maps every frontyard bucket onto backyard buckets of its own region, so (with huge pages) a frontyard bucket and all its backyard choices are on the same page. The empty buckets have to be all zero bytes, which they are.
+    enum class BucketLayout {Separate, Interleaved};
+
+    //Where a full frontyard bucket sends its overflow before the backyard. With Partner, bucket i is paired with bucket i + NumFrontyardBuckets/2 (and the other way around), and keys that do not fit in their own bucket go to the other one of the pair while it has room.
+    //Sibling pairs bucket i with bucket i^1 instead, which with 32 byte frontyard buckets is the other half of the same cacheline, so looking in the partner costs no extra cache miss (and no extra lock).
+    //Stored remainders then have a bit on top of the fingerprint saying whether the key spilled over from the partner, so the fingerprint is a bit shorter.
+    enum class FrontyardSpill {None, Partner, Sibling};
+
+    template<std::size_t SizeRemainders, std::size_t BucketNumMiniBuckets, std::size_t FrontyardBucketCapacity = 51, std::size_t BackyardBucketCapacity = 35, std::size_t FrontyardToBackyardRatio = 8, std::size_t FrontyardBucketSize = 64, std::size_t BackyardBucketSize = 64, bool FastSQuery = false, bool Threaded = false, std::size_t EpochBits = 0, bool LazyBackyard = false, SelectType Select = SelectType::Pdep, FrontyardSpill Spill = FrontyardSpill::None, std::size_t BackyardChoices = 2, BucketLayout Layout = BucketLayout::Separate>
     class PartitionQuotientFilter {
-        static_assert(FrontyardBucketSize == 32 || FrontyardBucketSize == 64);
+        static_assert(FrontyardBucketSize == 32 || FrontyardBucketSize == 64 || FrontyardBucketSize == 128);
         static_assert(BackyardBucketSize == 32 || BackyardBucketSize == 64);
+        static_assert(FrontyardBucketSize != 128 || SizeRemainders == 16, "128 byte buckets only have a remainder store for 16 bit remainders");
+        static_assert(EpochBits < SizeRemainders);
+        static_assert(Spill == FrontyardSpill::None || EpochBits == 0, "Expiry does not support spilling over into the partner bucket");
+        static_assert(!(LazyBackyard && Layout == BucketLayout::Interleaved), "An interleaved backyard is allocated along with the frontyard, so it cannot be lazy");
+        static_assert(FrontyardBucketSize <= 64 || Layout == BucketLayout::Separate, "The interleaved layout packs whole cachelines of frontyard buckets");
 
         private:
             using FrontyardQRContainerType = FrontyardQRContainer<BucketNumMiniBuckets>;
-            using FrontyardBucketType = Bucket<SizeRemainders, FrontyardBucketCapacity, BucketNumMiniBuckets, FrontyardQRContainer, FrontyardBucketSize, FastSQuery, Threaded>;
+            using FrontyardBucketType = Bucket<SizeRemainders, FrontyardBucketCapacity, BucketNumMiniBuckets, FrontyardQRContainer, FrontyardBucketSize, FastSQuery, Threaded, Select>;
             static_assert(sizeof(FrontyardBucketType) == FrontyardBucketSize);
-            using BackyardQRContainerType = BackyardQRContainer<BucketNumMiniBuckets, SizeRemainders, FrontyardToBackyardRatio>;
+            using BackyardQRContainerType = BackyardQRContainer<BucketNumMiniBuckets, SizeRemainders, FrontyardToBackyardRatio, BackyardChoices>;
             template<size_t NumMiniBuckets>
-            using WrappedBackyardQRContainerType = BackyardQRContainer<NumMiniBuckets, SizeRemainders, FrontyardToBackyardRatio>;
-            using BackyardBucketType = Bucket<SizeRemainders + 4, BackyardBucketCapacity, BucketNumMiniBuckets, WrappedBackyardQRContainerType, BackyardBucketSize, FastSQuery, Threaded>;
+            using WrappedBackyardQRContainerType = BackyardQRContainer<NumMiniBuckets, SizeRemainders, FrontyardToBackyardRatio, BackyardChoices>;
+            //Every backyard bucket a frontyard bucket can overflow into, see BackyardQRContainer
+            using BackyardQRs = std::array<BackyardQRContainerType, BackyardChoices>;
+            using BackyardBucketType = Bucket<SizeRemainders + BackyardQRContainerType::TagBits, BackyardBucketCapacity, BucketNumMiniBuckets, WrappedBackyardQRContainerType, BackyardBucketSize, FastSQuery, Threaded, Select, BackyardRemainderStore<BackyardQRContainerType::TagBits>::template Type>;
             static_assert(sizeof(BackyardBucketType) == BackyardBucketSize);
 
             inline static constexpr double NormalizingFactor = (double)FrontyardBucketCapacity / (double) BucketNumMiniBuckets * (double)(1+FrontyardToBackyardRatio*FrontyardBucketSize/BackyardBucketSize)/(FrontyardToBackyardRatio*FrontyardBucketSize/BackyardBucketSize);
@@ -100,259 +551,743 @@ namespace PQF {
             // static constexpr uint64_t HashMask = (1ull << SizeRemainders) - 1;
             const uint64_t RealRemainderSize, HashMask;
 
-            static_assert(64 % FrontyardBucketSize == 0 && 64 % BackyardBucketSize == 0);
+            static constexpr std::uint64_t SpillBits = Spill == FrontyardSpill::None ? 0 : 1;
+
+            //Set in the stored remainder of a key that spilled over into the partner of its bucket
+            inline std::uint64_t spillBit() const {
+                return SpillBits << RealRemainderSize;
+            }
+
+            //Partner pairs i and i + half, so that a bucket and its partner overflow independently, and Sibling pairs the two buckets of a cacheline. With an odd number of buckets the last one has no partner, which is it being its own partner.
+            inline std::size_t spillPartner(std::size_t i) const {
+                if constexpr (Spill == FrontyardSpill::Partner) {
+                    std::size_t half = frontyard.size() / 2;
+                    return i < half ? i + half : (i < 2*half ? i - half : i);
+                }
+                else if constexpr (Spill == FrontyardSpill::Sibling) {
+                    return (i^1) < frontyard.size() ? i^1 : i;
+                }
+                return i;
+            }
+
+            //The same key as stored in the partner of its bucket, and back
+            inline FrontyardQRContainerType spilledQR(FrontyardQRContainerType qr) const {
+                qr.bucketIndex = spillPartner(qr.bucketIndex);
+                qr.remainder |= spillBit();
+                return qr;
+            }
+
+            inline FrontyardQRContainerType unspilledQR(FrontyardQRContainerType qr) const {
+                qr.bucketIndex = spillPartner(qr.bucketIndex);
+                qr.remainder &= ~spillBit();
+                return qr;
+            }
+
+            static_assert((64 % FrontyardBucketSize == 0 || FrontyardBucketSize % 64 == 0) && 64 % BackyardBucketSize == 0);
+
+            static constexpr std::size_t frontyardLockCachelineMask = ~(std::max<std::size_t>(64 / FrontyardBucketSize, 1) - 1); //So that if multiple buckets in same cacheline, we always pick the same one to lock to not get corruption.
+
+            //128 byte buckets span two cachelines, and the adjacent line prefetcher is not something to count on, so both get prefetched
+            inline void prefetchFrontyard(std::size_t i) const {
+                const char* bucket = reinterpret_cast<const char*>(&frontyard[i]);
+                __builtin_prefetch(bucket);
+                if constexpr (FrontyardBucketSize > 64) {
+                    __builtin_prefetch(bucket + 64);
+                }
+            }
 
-            static constexpr std::size_t frontyardLockCachelineMask = ~(64ull / FrontyardBucketSize - 1); //So that if multiple buckets in same cacheline, we always pick the same one to lock to not get corruption.
+            //Anything done to a bucket can touch its partner, so both get locked, in index order
             inline void lockFrontyard(std::size_t i) {
                 if constexpr (Threaded) {
-                    frontyard[i & frontyardLockCachelineMask].lock();
+                    std::size_t i1 = i & frontyardLockCachelineMask;
+                    std::size_t i2 = spillPartner(i) & frontyardLockCachelineMask;
+                    if (i1 > i2) std::swap(i1, i2);
+                    frontyard[i1].lock();
+                    if (i1 != i2) frontyard[i2].lock();
                 }
             }
             inline void unlockFrontyard(std::size_t i) {
                 if constexpr (Threaded) {
-                    frontyard[i & frontyardLockCachelineMask].unlock();
+                    std::size_t i1 = i & frontyardLockCachelineMask;
+                    std::size_t i2 = spillPartner(i) & frontyardLockCachelineMask;
+                    if (i1 != i2) frontyard[i2].unlock();
+                    frontyard[i1].unlock();
                 }
             }
 
             inline static constexpr std::size_t backyardLockCachelineMask = ~(64ull / BackyardBucketSize - 1);
 
-            inline void lockBackyard(std::size_t i1, std::size_t i2) {
+            //The distinct lock units of the first numChoices backyard buckets, in index order
+            inline std::pair<std::array<std::size_t, BackyardChoices>, std::size_t> backyardLockUnits(const BackyardQRs& backyardQRs, std::size_t numChoices) const {
+                std::array<std::size_t, BackyardChoices> units;
+                for(std::size_t k = 0; k < numChoices; k++) {
+                    units[k] = backyardQRs[k].bucketIndex & backyardLockCachelineMask;
+                }
+                std::sort(units.begin(), units.begin() + numChoices);
+                return {units, std::unique(units.begin(), units.begin() + numChoices) - units.begin()};
+            }
+
+            //For the paths that may insert into the backyard buckets
+            inline void lockBackyard(const BackyardQRs& backyardQRs) {
                 if constexpr (Threaded) {
-                    i1 &= backyardLockCachelineMask;
-                    i2 &= backyardLockCachelineMask;
-                    if (i1 == i2) { 
-                        backyard[i1].lock();
-                        return;
+                    //The lock lives in the bucket, so it cannot be in the shared empty region of a lazy backyard
+                    for(const BackyardQRContainerType& backyardQR: backyardQRs) {
+                        backyard().materialize(backyardQR.bucketIndex);
+                    }
+                    auto [units, numUnits] = backyardLockUnits(backyardQRs, BackyardChoices);
+                    for(std::size_t k = 0; k < numUnits; k++) {
+                        backyard()[units[k]].lock();
                     }
-                    if (i1 > i2) std::swap(i1, i2);
-                    backyard[i1].lock();
-                    backyard[i2].lock();
                 }
             }
 
-            inline void unlockBackyard(std::size_t i1, std::size_t i2) {
+            //For the paths that only look up or remove keys of the frontyard bucket of the backyard QRs. Returns how many of them to look at, which lockBackyard has moved to the front.
+            //Keys only go to the backyard under the lock of their frontyard bucket, which these paths hold, so a backyard region of a lazy backyard that is not there yet has none of the keys and stays that way. Those choices are left out rather than materialized, so that lookups do not allocate.
+            inline std::size_t lockBackyardForLookup(BackyardQRs& backyardQRs) {
+                std::size_t numChoices = BackyardChoices;
+                if constexpr (Threaded && LazyBackyard) {
+                    numChoices = std::stable_partition(backyardQRs.begin(), backyardQRs.end(), [this](const BackyardQRContainerType& backyardQR) {
+                        return backyard().isMaterialized(backyardQR.bucketIndex);
+                    }) - backyardQRs.begin();
+                }
                 if constexpr (Threaded) {
-                    i1 &= backyardLockCachelineMask;
-                    i2 &= backyardLockCachelineMask;
-                    if (i1 == i2) { 
-                        backyard[i1].unlock();
-                        return;
+                    auto [units, numUnits] = backyardLockUnits(backyardQRs, numChoices);
+                    for(std::size_t k = 0; k < numUnits; k++) {
+                        backyard()[units[k]].lock();
+                    }
+                }
+                return numChoices;
+            }
+
+            inline void unlockBackyard(const BackyardQRs& backyardQRs, std::size_t numChoices = BackyardChoices) {
+                if constexpr (Threaded) {
+                    auto [units, numUnits] = backyardLockUnits(backyardQRs, numChoices);
+                    for(std::size_t k = numUnits; k-- > 0;) {
+                        backyard()[units[k]].unlock();
                     }
-                    // if (i1 > i2) std::swap(i1, i2);
-                    backyard[i2].unlock();
-                    backyard[i1].unlock();
                 }
             }
             
             std::uint64_t R;
+
+            //Epoch tags for per entry expiry (EpochBits > 0): the low EpochBits bits of every stored remainder are the epoch it was inserted in (mod 2^EpochBits) rather than bits of the hash, so the fingerprint is SizeRemainders-EpochBits bits.
+            //An entry is live while it is less than ttlEpochs epochs old. Since tags wrap around, every expired entry must be evicted before its tag gets reused, which advanceEpoch makes sure of by finishing a full sweep if needed.
+            static constexpr std::uint64_t NumEpochTags = 1ull << EpochBits;
+            static constexpr std::uint64_t EpochMask = NumEpochTags - 1;
+            std::uint64_t currentEpoch = 0;
+            std::uint64_t ttlEpochs = NumEpochTags - 1;
+            std::size_t sweepCursor = 0;
+            std::uint64_t sweepStartEpoch = 0;
+            std::uint64_t lastCompletedSweepStart = 0; //Nothing can be expired in epoch 0, so we can pretend a sweep just finished then
+
+            inline bool isExpired(std::uint64_t remainder) const {
+                return ((currentEpoch - remainder) & EpochMask) >= ttlEpochs;
+            }
+
+            inline void tagWithEpoch(FrontyardQRContainerType& frontyardQR) const {
+                if constexpr (EpochBits > 0) {
+                    frontyardQR.remainder = (frontyardQR.remainder & ~EpochMask) | (currentEpoch & EpochMask);
+                }
+            }
+
+            //Fills remainders with the remainder tagged with every live epoch, newest first, and returns how many there are
+            inline std::size_t getLiveRemainders(std::uint64_t remainder, std::array<std::uint64_t, NumEpochTags>& remainders) const {
+                for(std::size_t age = 0; age < ttlEpochs; age++) {
+                    remainders[age] = (remainder & ~EpochMask) | ((currentEpoch - age) & EpochMask);
+                }
+                return ttlEpochs;
+            }
             // std::map<std::pair<std::uint64_t, std::uint64_t>, std::uint64_t> backyardToFrontyard; //Comment this out when done with testing I guess?
             // std::vector<size_t> overflows;
             inline FrontyardQRContainerType getQRPairFromHash(std::uint64_t hash) {
                 if constexpr (DEBUG) {
                     FrontyardQRContainerType f = FrontyardQRContainerType(hash >> SizeRemainders, hash & HashMask);
                     assert(f.bucketIndex < frontyard.size());
+                    for(const BackyardQRContainerType& fb: getBackyardQRs(f)) {
+                        assert(fb.bucketIndex < backyard().size());
+                    }
+                }
+                return FrontyardQRContainerType(hash >> RealRemainderSize, hash & HashMask);
+            }
+
+            //The R of the backyard mapping, which for an interleaved filter with several regions maps the frontyard of a region onto the backyard of that region
+            inline std::uint64_t backyardMappingR() const {
+                std::size_t mappedFrontyardSize = frontyard.size();
+                if constexpr (Interleaved) {
+                    if(frontyard.multipleRegions()) mappedFrontyardSize = InterleavedBucketsType::FrontyardPerRegion;
+                }
+                std::uint64_t r = mappedFrontyardSize / FrontyardToBackyardRatio / FrontyardToBackyardRatio + 1;
+                if(r % (FrontyardToBackyardRatio - 1) == 0) r++;
+                return r;
+            }
+
+            inline BackyardQRs getBackyardQRs(FrontyardQRContainerType frontyardQR, std::size_t backyardSize) const {
 #ifdef CUCKOO_HASH
-                    BackyardQRContainerType fb1(f, 0, R, backyard.size());
-                    BackyardQRContainerType fb2(f, 1, R, backyard.size());
+                BackyardQRs backyardQRs{BackyardQRContainerType(frontyardQR, 0, R, backyardSize), BackyardQRContainerType(frontyardQR, 1, R, backyardSize)};
 #else
-                    BackyardQRContainerType fb1(f, 0, R);
-                    BackyardQRContainerType fb2(f, 1, R);
+                BackyardQRs backyardQRs{BackyardQRContainerType(frontyardQR, 0, R), BackyardQRContainerType(frontyardQR, 1, R)};
 #endif
-
-                    assert(fb1.bucketIndex < backyard.size() && fb2.bucketIndex < backyard.size());
+                for(std::size_t k = 2; k < BackyardChoices; k++) {
+                    backyardQRs[k] = backyardQRs[k-2];
+                    backyardQRs[k].moveToUpperHalf(backyardSize);
                 }
-                return FrontyardQRContainerType(hash >> RealRemainderSize, hash & HashMask);
+                return backyardQRs;
             }
 
-            inline bool insertOverflow(FrontyardQRContainerType overflow, BackyardQRContainerType firstBackyardQR, BackyardQRContainerType secondBackyardQR) {
-                std::size_t fillOfFirstBackyardBucket = backyard[firstBackyardQR.bucketIndex].countKeys();
-                std::size_t fillOfSecondBackyardBucket = backyard[secondBackyardQR.bucketIndex].countKeys();
-                
-                if(fillOfFirstBackyardBucket < fillOfSecondBackyardBucket) {
-                    if constexpr (PARTIAL_DEBUG || DEBUG)
-                        assert(backyard[firstBackyardQR.bucketIndex].insert(firstBackyardQR).miniBucketIndex == -1ull); //Failing this would be *really* bad, as it is the main unproven assumption this algo relies on
-                    else {
-                        if constexpr (DIAGNOSTICS) {
-                            bool success = backyard[firstBackyardQR.bucketIndex].insert(firstBackyardQR).miniBucketIndex == -1ull;
-                            failureFB = overflow.bucketIndex;
-                            failureBucket1 = firstBackyardQR.bucketIndex;
-                            failureBucket2 = secondBackyardQR.bucketIndex;
-                            failureWFB = firstBackyardQR.whichFrontyardBucket;
-                            insertFailure = !success;
-                            return success;
-                        }
-                        else {
-                            backyard[firstBackyardQR.bucketIndex].insert(firstBackyardQR);
+            inline BackyardQRs getBackyardQRs(FrontyardQRContainerType frontyardQR) const {
+                if constexpr (Interleaved) {
+                    //The usual mapping within the region, shifted over to the backyard of the region
+                    if(frontyard.multipleRegions()) {
+                        std::size_t region = frontyardQR.bucketIndex / InterleavedBucketsType::FrontyardPerRegion;
+                        frontyardQR.bucketIndex %= InterleavedBucketsType::FrontyardPerRegion;
+                        BackyardQRs backyardQRs = getBackyardQRs(frontyardQR, InterleavedBucketsType::BackyardPerRegion);
+                        for(BackyardQRContainerType& backyardQR: backyardQRs) {
+                            backyardQR.bucketIndex += region*InterleavedBucketsType::BackyardPerRegion;
                         }
+                        return backyardQRs;
                     }
                 }
-                else {
-                    if constexpr (PARTIAL_DEBUG || DEBUG)
-                        assert(backyard[secondBackyardQR.bucketIndex].insert(secondBackyardQR).miniBucketIndex == -1ull);
-                    else {
-                        if constexpr (DIAGNOSTICS) {
-                            bool success = backyard[secondBackyardQR.bucketIndex].insert(secondBackyardQR).miniBucketIndex == -1ull;
-                            insertFailure = !success;
-                            failureFB = overflow.bucketIndex;
-                            failureBucket1 = firstBackyardQR.bucketIndex;
-                            failureBucket2 = secondBackyardQR.bucketIndex;
-                            failureWFB = firstBackyardQR.whichFrontyardBucket;
-                            if(!success) {
-                                std::cerr << firstBackyardQR.bucketIndex << " " << secondBackyardQR.bucketIndex << std::endl;
-                            }
-                            return success;
-                        }
-                        else {
-                            return backyard[secondBackyardQR.bucketIndex].insert(secondBackyardQR).miniBucketIndex == -1ull;
+                return getBackyardQRs(frontyardQR, backyard().size());
+            }
+
+            //Goes to the emptiest of the backyard buckets, the later choice on a tie
+            inline bool insertOverflow(FrontyardQRContainerType overflow, BackyardQRs backyardQRs) {
+                std::size_t best = 0;
+                std::size_t bestFill = backyard()[backyardQRs[0].bucketIndex].countKeys();
+                for(std::size_t k = 1; k < BackyardChoices; k++) {
+                    std::size_t fill = backyard()[backyardQRs[k].bucketIndex].countKeys();
+                    if(fill <= bestFill) {
+                        best = k;
+                        bestFill = fill;
+                    }
+                }
+                BackyardQRContainerType& backyardQR = backyardQRs[best];
+
+                backyard().materialize(backyardQR.bucketIndex);
+                if constexpr (PARTIAL_DEBUG || DEBUG) {
+                    //Only the last choice can be full here, as then every other one is too
+                    bool success = backyard()[backyardQR.bucketIndex].insert(backyardQR).miniBucketIndex == -1ull;
+                    assert(success || best == BackyardChoices-1);
+                    return success;
+                }
+                else if constexpr (DIAGNOSTICS) {
+                    bool success = backyard()[backyardQR.bucketIndex].insert(backyardQR).miniBucketIndex == -1ull;
+                    insertFailure = !success;
+                    failureFB = overflow.bucketIndex;
+                    failureBucket1 = backyardQRs[0].bucketIndex;
+                    failureBucket2 = backyardQRs[1].bucketIndex;
+                    failureWFB = backyardQRs[0].whichFrontyardBucket;
+                    if(!success) {
+                        for(const BackyardQRContainerType& qr: backyardQRs) {
+                            std::cerr << qr.bucketIndex << " ";
                         }
+                        std::cerr << std::endl;
                     }
+                    return success;
+                }
+                else {
+                    return backyard()[backyardQR.bucketIndex].insert(backyardQR).miniBucketIndex == -1ull;
                 }
-                return true;
             }
 
-            inline std::uint64_t queryBackyard(FrontyardQRContainerType overflow, BackyardQRContainerType firstBackyardQR, BackyardQRContainerType secondBackyardQR) {
-                return backyard[firstBackyardQR.bucketIndex].querySimple(firstBackyardQR) || backyard[secondBackyardQR.bucketIndex].querySimple(secondBackyardQR);
+            //Every choice has its own tag, so a hit in one is the key and the rest need not be looked at. Past two choices, the misses of all of them are started up front.
+            inline std::uint64_t queryBackyard(FrontyardQRContainerType overflow, const BackyardQRs& backyardQRs, std::size_t numChoices = BackyardChoices) {
+                if constexpr (BackyardChoices > 2) {
+                    for(std::size_t k = 0; k < numChoices; k++) {
+                        __builtin_prefetch(&backyard()[backyardQRs[k].bucketIndex]);
+                    }
+                }
+                for(std::size_t k = 0; k < numChoices; k++) {
+                    if(backyard()[backyardQRs[k].bucketIndex].querySimple(backyardQRs[k])) return true;
+                }
+                return false;
             }
 
-            inline bool removeFromBackyard(FrontyardQRContainerType frontyardQR, BackyardQRContainerType firstBackyardQR, BackyardQRContainerType secondBackyardQR, bool elementInFrontyard) {
-                if (elementInFrontyard) { //In the case we removed it from the frontyard bucket, we need to bring back an element from the backyard (if there is one)
-                    //Pretty messy since need to figure out who in the backyard has the key with a smaller miniBucket, since we want to bring the key with the smallest miniBucket index back into the frontyard
-                    std::size_t fillOfFirstBackyardBucket = backyard[firstBackyardQR.bucketIndex].countKeys();
-                    std::size_t fillOfSecondBackyardBucket = backyard[secondBackyardQR.bucketIndex].countKeys();
-                    if(fillOfFirstBackyardBucket==0 && fillOfSecondBackyardBucket==0) return true;
-                    // todo which frontyard bucket
-                    std::uint64_t keysFromFrontyardInFirstBackyard = backyard[firstBackyardQR.bucketIndex].remainderStore.query4BitPartMask(firstBackyardQR.whichFrontyardBucket, (1ull << fillOfFirstBackyardBucket) - 1);
-                    std::uint64_t keysFromFrontyardInSecondBackyard = backyard[secondBackyardQR.bucketIndex].remainderStore.query4BitPartMask(secondBackyardQR.whichFrontyardBucket, (1ull << fillOfSecondBackyardBucket) - 1);
+            struct BackyardKeyLocation {
+                std::size_t bucketIndex;
+                std::size_t keyIndex;
+                std::uint64_t miniBucketIndex; //-1ull if there is no such key
+            };
+
+            //Finds the key with the smallest miniBucket among the ones the frontyard bucket of the backyard QRs sent to the backyard
+            inline BackyardKeyLocation smallestBackyardKey(const BackyardQRs& backyardQRs, std::size_t numChoices = BackyardChoices) {
+                //Need to figure out who in the backyard has the key with a smaller miniBucket. Keys are sorted by miniBucket within a bucket, so only the first one from this frontyard bucket in each counts
+                BackyardKeyLocation smallest{0, 0, -1ull};
+                for(std::size_t k = 0; k < numChoices; k++) {
+                    const BackyardQRContainerType& backyardQR = backyardQRs[k];
                     if constexpr (DEBUG) {
-                        assert(firstBackyardQR.whichFrontyardBucket == firstBackyardQR.remainder >> SizeRemainders);
-                        assert(secondBackyardQR.whichFrontyardBucket == secondBackyardQR.remainder >> SizeRemainders);
-                    }
-                    if(keysFromFrontyardInFirstBackyard == 0 && keysFromFrontyardInSecondBackyard == 0) return true;
-                    std::uint64_t firstKeyBackyard = __builtin_ctzll(keysFromFrontyardInFirstBackyard);
-                    std::uint64_t secondKeyBackyard = __builtin_ctzll(keysFromFrontyardInSecondBackyard);
-                    std::uint64_t firstMiniBucketBackyard = backyard[firstBackyardQR.bucketIndex].queryWhichMiniBucket(firstKeyBackyard);
-                    std::uint64_t secondMiniBucketBackyard = backyard[secondBackyardQR.bucketIndex].queryWhichMiniBucket(secondKeyBackyard);
-                    if constexpr (DEBUG) {
-                        assert(firstMiniBucketBackyard >= frontyard[frontyardQR.bucketIndex].queryWhichMiniBucket(FrontyardBucketCapacity-2) && secondMiniBucketBackyard >= frontyard[frontyardQR.bucketIndex].queryWhichMiniBucket(FrontyardBucketCapacity-2));
+                        assert(backyardQR.whichFrontyardBucket == backyardQR.remainder >> SizeRemainders);
                     }
-                    if(firstMiniBucketBackyard < secondMiniBucketBackyard) {
-                        frontyardQR.miniBucketIndex = firstMiniBucketBackyard;
-                        frontyardQR.remainder = backyard[firstBackyardQR.bucketIndex].remainderStoreRemoveReturn(firstKeyBackyard, firstMiniBucketBackyard) & HashMask;
+                    std::size_t fill = backyard()[backyardQR.bucketIndex].countKeys();
+                    if(fill == 0) continue;
+                    std::uint64_t keysFromFrontyard = backyard()[backyardQR.bucketIndex].remainderStore.querySecondPartMask(backyardQR.whichFrontyardBucket, (1ull << fill) - 1);
+                    if(keysFromFrontyard == 0) continue;
+                    std::uint64_t keyIndex = __builtin_ctzll(keysFromFrontyard);
+                    std::uint64_t miniBucketIndex = backyard()[backyardQR.bucketIndex].queryWhichMiniBucket(keyIndex);
+                    if(miniBucketIndex <= smallest.miniBucketIndex) {
+                        smallest = {backyardQR.bucketIndex, keyIndex, miniBucketIndex};
                     }
-                    else {
-                        frontyardQR.miniBucketIndex = secondMiniBucketBackyard;
-                        frontyardQR.remainder = backyard[secondBackyardQR.bucketIndex].remainderStoreRemoveReturn(secondKeyBackyard, secondMiniBucketBackyard) & HashMask;
+                }
+                return smallest;
+            }
+
+            inline bool removeFromBackyard(FrontyardQRContainerType frontyardQR, const BackyardQRs& backyardQRs, bool elementInFrontyard, std::size_t numChoices = BackyardChoices) {
+                if (elementInFrontyard) { //In the case we removed it from the frontyard bucket, we need to bring back an element from the backyard (if there is one)
+                    //We want to bring the key with the smallest miniBucket index back into the frontyard
+                    BackyardKeyLocation backyardKey = smallestBackyardKey(backyardQRs, numChoices);
+                    if(backyardKey.miniBucketIndex == -1ull) return true;
+                    if constexpr (DEBUG) {
+                        assert(backyardKey.miniBucketIndex >= frontyard[frontyardQR.bucketIndex].queryWhichMiniBucket(FrontyardBucketCapacity-2));
                     }
+                    frontyardQR.miniBucketIndex = backyardKey.miniBucketIndex;
+                    frontyardQR.remainder = backyard()[backyardKey.bucketIndex].remainderStoreRemoveReturn(backyardKey.keyIndex, backyardKey.miniBucketIndex) & HashMask;
                     frontyard[frontyardQR.bucketIndex].insert(frontyardQR);
                 }
                 else {
-                    if (!backyard[firstBackyardQR.bucketIndex].remove(firstBackyardQR)) {
-                        return backyard[secondBackyardQR.bucketIndex].remove(secondBackyardQR);
+                    for(std::size_t k = 0; k < numChoices; k++) {
+                        if(backyard()[backyardQRs[k].bucketIndex].remove(backyardQRs[k])) return true;
                     }
+                    return false;
                 }
                 return true;
             }
 
+            //Puts a key a full frontyard bucket pushed out where it goes next. With spilling, a key that had spilled over from the partner goes to the backyard of its own bucket, and one of the bucket's own goes to the partner if that has room.
+            inline bool placeOverflow(FrontyardQRContainerType overflow) {
+                if constexpr (Spill != FrontyardSpill::None) {
+                    if(overflow.remainder & spillBit()) {
+                        overflow = unspilledQR(overflow);
+                    }
+                    else if(spillPartner(overflow.bucketIndex) != overflow.bucketIndex && !frontyard[spillPartner(overflow.bucketIndex)].full()) {
+                        FrontyardQRContainerType partnerOverflow = frontyard[spillPartner(overflow.bucketIndex)].insert(spilledQR(overflow));
+                        if constexpr (DEBUG) {
+                            assert(partnerOverflow.miniBucketIndex == -1ull);
+                        }
+                        return true;
+                    }
+                }
+                BackyardQRs backyardQRs = getBackyardQRs(overflow);
+                lockBackyard(backyardQRs);
+
+                bool retval = insertOverflow(overflow, backyardQRs);
+
+                unlockBackyard(backyardQRs);
+                return retval;
+            }
+
             inline bool insertInner(FrontyardQRContainerType frontyardQR) {
                 FrontyardQRContainerType overflow = frontyard[frontyardQR.bucketIndex].insert(frontyardQR);
                 if constexpr (DEBUG) {
                     assert((uint64_t)(&frontyard[frontyardQR.bucketIndex]) % FrontyardBucketSize == 0);
                 }
                 if(overflow.miniBucketIndex != -1ull) {
-#ifdef CUCKOO_HASH
-                    BackyardQRContainerType firstBackyardQR(overflow, 0, R, backyard.size());
-                    BackyardQRContainerType secondBackyardQR(overflow, 1, R, backyard.size());
-#else
-                    BackyardQRContainerType firstBackyardQR(overflow, 0, R);
-                    BackyardQRContainerType secondBackyardQR(overflow, 1, R);
-#endif
-                    lockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
-
-                    bool retval = insertOverflow(overflow, firstBackyardQR, secondBackyardQR);
-
-                    unlockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
-                    return retval;
+                    return placeOverflow(overflow);
                 }
                 return true;
             }
+
+            //For a key its frontyard bucket sent on (query returned 2): 1 if it spilled over into the partner, 0 if it is not there and the partner has room (so nothing of the bucket is in the backyard), 2 if the backyard needs to be checked
+            inline std::uint64_t queryPartner(FrontyardQRContainerType frontyardQR) {
+                if constexpr (Spill != FrontyardSpill::None) {
+                    std::size_t partner = spillPartner(frontyardQR.bucketIndex);
+                    if(partner == frontyardQR.bucketIndex) return 2;
+                    if(frontyard[partner].querySimple(spilledQR(frontyardQR))) return 1;
+                    if(!frontyard[partner].full()) return 0;
+                }
+                return 2;
+            }
             inline std::uint64_t queryWhereInner(FrontyardQRContainerType frontyardQR) {
                 std::uint64_t frontyardQuery = frontyard[frontyardQR.bucketIndex].query(frontyardQR);
                 if(frontyardQuery != 2) return frontyardQuery;
+                std::uint64_t partnerQuery = queryPartner(frontyardQR);
+                if(partnerQuery != 2) return partnerQuery;
 
                 if constexpr (DIAGNOSTICS) {
                     backyardLookupCount ++;
                 }
-#ifdef CUCKOO_HASH
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R, backyard.size());
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R, backyard.size());
-#else
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R);
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R);
-#endif
-                lockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                std::size_t numChoices = lockBackyardForLookup(backyardQRs);
 
-                std::uint64_t retval = queryBackyard(frontyardQR, firstBackyardQR, secondBackyardQR);
+                std::uint64_t retval = queryBackyard(frontyardQR, backyardQRs, numChoices);
 
-                unlockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                unlockBackyard(backyardQRs, numChoices);
 
                 return retval | 2;
             }
+            //queryWhereInner for filters with epoch tags, where the key counts as present if it is stored under any live tag
+            inline std::uint64_t queryWhereTaggedInner(FrontyardQRContainerType frontyardQR) {
+                std::array<std::uint64_t, NumEpochTags> remainders;
+                std::size_t numRemainders = getLiveRemainders(frontyardQR.remainder, remainders);
+                std::uint64_t frontyardQuery = frontyard[frontyardQR.bucketIndex].queryAny(frontyardQR, remainders.data(), numRemainders);
+                if(frontyardQuery != 2) return frontyardQuery;
+
+                if constexpr (DIAGNOSTICS) {
+                    backyardLookupCount ++;
+                }
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                std::size_t numChoices = lockBackyardForLookup(backyardQRs);
+
+                std::uint64_t retval = 0;
+                for(std::size_t j = 0; j < numRemainders && !retval; j++) {
+                    for(BackyardQRContainerType& backyardQR: backyardQRs) {
+                        backyardQR.remainder = (backyardQR.remainder & ~HashMask) | remainders[j];
+                    }
+                    retval = queryBackyard(frontyardQR, backyardQRs, numChoices);
+                }
+
+                unlockBackyard(backyardQRs, numChoices);
+
+                return retval | 2;
+            }
+
             inline bool queryInner(FrontyardQRContainerType frontyardQR) {
+                if constexpr (EpochBits > 0) {
+                    return queryWhereTaggedInner(frontyardQR) & 1;
+                }
                 std::uint64_t frontyardQuery = frontyard[frontyardQR.bucketIndex].query(frontyardQR);
                 if(frontyardQuery != 2) return frontyardQuery;
+                std::uint64_t partnerQuery = queryPartner(frontyardQR);
+                if(partnerQuery != 2) return partnerQuery;
 
                 if constexpr (DIAGNOSTICS) {
                     backyardLookupCount ++;
                 }
-#ifdef CUCKOO_HASH
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R, backyard.size());
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R, backyard.size());
-#else
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R);
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R);
-#endif
-                lockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                std::size_t numChoices = lockBackyardForLookup(backyardQRs);
 
-                bool retval = queryBackyard(frontyardQR, firstBackyardQR, secondBackyardQR);
+                bool retval = queryBackyard(frontyardQR, backyardQRs, numChoices);
 
-                unlockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                unlockBackyard(backyardQRs, numChoices);
 
                 return retval;
             }
 
-            inline bool removeInner(FrontyardQRContainerType frontyardQR) {
-#ifdef CUCKOO_HASH
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R, backyard.size());
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R, backyard.size());
-#else
-                BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R);
-                BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R);
-#endif
+            //Returns 1 if the key was already there, 0 if it was not and got inserted, 2 if it was not and inserting it failed
+            inline std::uint64_t insertIfAbsentInner(FrontyardQRContainerType frontyardQR) {
+                if constexpr (EpochBits > 0) { //Needs to match every live tag, so not fused, but still under the one frontyard lock
+                    if(queryWhereTaggedInner(frontyardQR) & 1) return 1;
+                    tagWithEpoch(frontyardQR);
+                    if(frontyard[frontyardQR.bucketIndex].full()) {
+                        evictExpired(frontyardQR.bucketIndex);
+                    }
+                    return insertInner(frontyardQR) ? 0 : 2;
+                }
+                if constexpr (Spill != FrontyardSpill::None) { //The key may be in the partner, and the overflow may go there, so not fused either
+                    if(queryInner(frontyardQR)) return 1;
+                    return insertInner(frontyardQR) ? 0 : 2;
+                }
+
+                FrontyardQRContainerType overflow = frontyardQR;
+                std::uint64_t frontyardResult = frontyard[frontyardQR.bucketIndex].queryOrInsert(overflow);
+                if(frontyardResult == 1 || (frontyardResult == 0 && overflow.miniBucketIndex == -1ull)) return frontyardResult;
+
+                //Either the frontyard bucket overflowed on the insert, or we need to look in the backyard before inserting. Both only touch the backyard buckets of this frontyard bucket, so lock them once for everything
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                lockBackyard(backyardQRs);
+
+                if(frontyardResult == 2) {
+                    if constexpr (DIAGNOSTICS) {
+                        backyardLookupCount ++;
+                    }
+                    if(queryBackyard(frontyardQR, backyardQRs)) {
+                        unlockBackyard(backyardQRs);
+                        return 1;
+                    }
+                    overflow = frontyard[frontyardQR.bucketIndex].insert(frontyardQR);
+                }
 
+                bool success = true;
+                if(overflow.miniBucketIndex != -1ull) {
+                    success = insertOverflow(overflow, getBackyardQRs(overflow));
+                }
+
+                unlockBackyard(backyardQRs);
+                return success ? 0 : 2;
+            }
+
+            inline bool removeInner(FrontyardQRContainerType frontyardQR) {
                 bool frontyardBucketFull = frontyard[frontyardQR.bucketIndex].full();
                 bool elementInFrontyard = frontyard[frontyardQR.bucketIndex].remove(frontyardQR);
                 if(!frontyardBucketFull) {
                     return elementInFrontyard;
                 }
                 else {
-#ifdef CUCKOO_HASH
-                    BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R, backyard.size());
-                    BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R, backyard.size());
-#else
-                    BackyardQRContainerType firstBackyardQR(frontyardQR, 0, R);
-                    BackyardQRContainerType secondBackyardQR(frontyardQR, 1, R);
-#endif
+                    if constexpr (Spill != FrontyardSpill::None) {
+                        if(elementInFrontyard) {
+                            refillFrontyardBucket(frontyardQR.bucketIndex);
+                            return true;
+                        }
+                        std::size_t partner = spillPartner(frontyardQR.bucketIndex);
+                        if(partner != frontyardQR.bucketIndex) {
+                            bool partnerFull = frontyard[partner].full();
+                            if(frontyard[partner].remove(spilledQR(frontyardQR))) {
+                                if(partnerFull) refillFrontyardBucket(partner);
+                                return true;
+                            }
+                        }
+                    }
+                    BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
 
-                    lockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                    std::size_t numChoices = lockBackyardForLookup(backyardQRs);
 
-                    bool retval = removeFromBackyard(frontyardQR, firstBackyardQR, secondBackyardQR, elementInFrontyard);
+                    bool retval = removeFromBackyard(frontyardQR, backyardQRs, elementInFrontyard, numChoices);
 
-                    unlockBackyard(firstBackyardQR.bucketIndex, secondBackyardQR.bucketIndex);
+                    unlockBackyard(backyardQRs, numChoices);
                     return retval;
                 }
                 return true;
             }
-        
+
+            //Frontyard bucket i just went from full to one key short: brings back its key with the smallest miniBucket from the partner or the backyard, wherever that is.
+            //If it has none out, it takes in one of the partner's backyard keys instead, since keys may only be in the backyard while the other bucket of their pair is full. Expects i and its partner to be locked.
+            inline void refillFrontyardBucket(std::size_t i) {
+                std::size_t partner = spillPartner(i);
+                //Spilled keys are sorted by miniBucket along with the partner's own, so the first one has the smallest
+                std::size_t partnerKey = -1ull;
+                std::uint64_t partnerMiniBucket = -1ull;
+                if(partner != i) {
+                    std::size_t numKeys = frontyard[partner].countKeys();
+                    for(std::size_t k = 0; k < numKeys; k++) {
+                        if(frontyard[partner].remainderStore.get(k) & spillBit()) {
+                            partnerKey = k;
+                            partnerMiniBucket = frontyard[partner].queryWhichMiniBucket(k);
+                            break;
+                        }
+                    }
+                }
+
+                FrontyardQRContainerType frontyardQR(i*BucketNumMiniBuckets, 0);
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                std::size_t numChoices = lockBackyardForLookup(backyardQRs);
+                BackyardKeyLocation backyardKey = smallestBackyardKey(backyardQRs, numChoices);
+                bool fromBackyard = backyardKey.miniBucketIndex < partnerMiniBucket;
+                if(fromBackyard) {
+                    frontyardQR.miniBucketIndex = backyardKey.miniBucketIndex;
+                    frontyardQR.remainder = backyard()[backyardKey.bucketIndex].remainderStoreRemoveReturn(backyardKey.keyIndex, backyardKey.miniBucketIndex) & HashMask;
+                    frontyard[i].insert(frontyardQR);
+                }
+                unlockBackyard(backyardQRs, numChoices);
+                if(fromBackyard) return;
+
+                if(partnerKey != -1ull) {
+                    bool partnerFull = frontyard[partner].full();
+                    frontyardQR.miniBucketIndex = partnerMiniBucket;
+                    frontyardQR.remainder = frontyard[partner].remainderStoreRemoveReturn(partnerKey, partnerMiniBucket) & HashMask;
+                    frontyard[i].insert(frontyardQR);
+                    if(partnerFull) refillFrontyardBucket(partner);
+                }
+                else if(partner != i) {
+                    FrontyardQRContainerType partnerQR(partner*BucketNumMiniBuckets, 0);
+                    BackyardQRs partnerBackyardQRs = getBackyardQRs(partnerQR);
+                    std::size_t partnerNumChoices = lockBackyardForLookup(partnerBackyardQRs);
+                    BackyardKeyLocation partnerBackyardKey = smallestBackyardKey(partnerBackyardQRs, partnerNumChoices);
+                    if(partnerBackyardKey.miniBucketIndex != -1ull) {
+                        partnerQR.miniBucketIndex = partnerBackyardKey.miniBucketIndex;
+                        partnerQR.remainder = backyard()[partnerBackyardKey.bucketIndex].remainderStoreRemoveReturn(partnerBackyardKey.keyIndex, partnerBackyardKey.miniBucketIndex) & HashMask;
+                        frontyard[i].insert(spilledQR(partnerQR));
+                    }
+                    unlockBackyard(partnerBackyardQRs, partnerNumChoices);
+                }
+            }
+
+            //Removes the expired entries belonging to frontyard bucket i. First the ones it overflowed into the backyard, so that refilling the frontyard bucket only ever brings back live keys, and then the frontyard ones, refilling from the backyard like removeInner does.
+            //Expects the frontyard bucket to be locked
+            inline void evictExpired(std::size_t i) {
+                FrontyardQRContainerType frontyardQR(i*BucketNumMiniBuckets, 0);
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                std::size_t numChoices = lockBackyardForLookup(backyardQRs);
+
+                //Going from the last key backwards so that removing a key does not move the ones still to be checked
+                auto evictFromBackyard = [&](BackyardBucketType& bucket, const BackyardQRContainerType& backyardQR) {
+                    for(std::size_t k = bucket.countKeys(); k-- > 0;) {
+                        std::uint64_t remainder = bucket.remainderStore.get(k);
+                        if((remainder & ~HashMask) == backyardQR.remainder && isExpired(remainder)) {
+                            bucket.remainderStoreRemoveReturn(k, bucket.queryWhichMiniBucket(k));
+                        }
+                    }
+                };
+                for(std::size_t k = 0; k < numChoices; k++) {
+                    evictFromBackyard(backyard()[backyardQRs[k].bucketIndex], backyardQRs[k]);
+                }
+
+                //A key brought back from the backyard can land in front of keys still to be checked, so start over from the end after a refill (only the keys brought back are rechecked, and they are live)
+                FrontyardBucketType& bucket = frontyard[i];
+                for(std::size_t k = bucket.countKeys(); k-- > 0;) {
+                    if(isExpired(bucket.remainderStore.get(k))) {
+                        bool frontyardBucketFull = bucket.full();
+                        bucket.remainderStoreRemoveReturn(k, bucket.queryWhichMiniBucket(k));
+                        if(frontyardBucketFull) {
+                            removeFromBackyard(frontyardQR, backyardQRs, true, numChoices);
+                            if(bucket.full()) {
+                                k = bucket.countKeys();
+                            }
+                        }
+                    }
+                }
+
+                unlockBackyard(backyardQRs, numChoices);
+            }
+
+            //Calls f(hash) for every hash that belongs to frontyard bucket i, wherever it is stored. Backyard keys get attributed back to i through the whichFrontyardBucket bits, same as in the merge.
+            template<typename F>
+            inline void forEachHashInFrontyardBucket(std::size_t i, F& f) const {
+                std::uint64_t bucketQuotient = i*BucketNumMiniBuckets;
+                frontyard[i].forEach([&](std::uint64_t miniBucketIndex, std::uint64_t remainder) {
+                    if(remainder & spillBit()) return; //Belongs to the partner
+                    f(((bucketQuotient + miniBucketIndex) << RealRemainderSize) | remainder);
+                });
+                if constexpr (Spill != FrontyardSpill::None) {
+                    if(spillPartner(i) != i) {
+                        frontyard[spillPartner(i)].forEach([&](std::uint64_t miniBucketIndex, std::uint64_t remainder) {
+                            if(remainder & spillBit()) {
+                                f(((bucketQuotient + miniBucketIndex) << RealRemainderSize) | (remainder & HashMask));
+                            }
+                        });
+                    }
+                }
+
+                FrontyardQRContainerType frontyardQR(bucketQuotient, 0);
+                BackyardQRs backyardQRs = getBackyardQRs(frontyardQR);
+                auto fromBackyard = [&](const BackyardBucketType& bucket, const BackyardQRContainerType& backyardQR) {
+                    bucket.forEach([&](std::uint64_t miniBucketIndex, std::uint64_t remainder) {
+                        if((remainder & ~HashMask) == backyardQR.remainder) {
+                            f(((bucketQuotient + miniBucketIndex) << RealRemainderSize) | (remainder & HashMask));
+                        }
+                    });
+                };
+                for(const BackyardQRContainerType& backyardQR: backyardQRs) {
+                    fromBackyard(backyard()[backyardQR.bucketIndex], backyardQR);
+                }
+            }
+
+            //Sizes of a fresh filter's frontyard and backyard for the given capacity
+            static std::size_t frontyardSizeFor(std::size_t capacity) {
+                return (capacity+BucketNumMiniBuckets-1)/BucketNumMiniBuckets;
+            }
+
+            static std::size_t backyardSizeFor(std::size_t capacity) {
+                return (frontyardSizeFor(capacity)+FrontyardToBackyardRatio-1)/FrontyardToBackyardRatio + FrontyardToBackyardRatio*2;
+            }
+
+            //Largest remainder size with which a filter of the given range has room for N keys, and checks that there is one
+            static std::uint64_t remainderSizeForRange(std::size_t N, std::size_t range, bool Normalize) {
+                std::size_t minCapacity = Normalize ? static_cast<size_t>(N/NormalizingFactor) : N;
+                if(range < minCapacity) {
+                    throw std::invalid_argument("The range is too small to give the filter the capacity asked for");
+                }
+                std::uint64_t remainderSize = 0;
+                while(remainderSize < SizeRemainders - SpillBits && (range >> (remainderSize+1)) >= minCapacity && (range & (1ull << remainderSize)) == 0) {
+                    remainderSize++;
+                }
+                return remainderSize;
+            }
+
+            //Remainder size of the output of merging the inputs, and checks that they can be merged
+            static std::uint64_t mergedRemainderSize(const std::vector<const PartitionQuotientFilter*>& inputs, std::optional<std::uint64_t> outputRemainderSize) {
+                if(inputs.empty()) {
+                    throw std::invalid_argument("Need at least one filter to merge");
+                }
+                std::size_t totalCapacity = 0;
+                std::uint64_t minInputRemainderSize = SizeRemainders - SpillBits;
+                for(const PartitionQuotientFilter* input: inputs) {
+                    if(input->range != inputs.at(0)->range) {
+                        throw std::invalid_argument("Merges must be of filters with the same range");
+                    }
+                    totalCapacity += input->capacity;
+                    minInputRemainderSize = std::min(minInputRemainderSize, input->RealRemainderSize);
+                }
+                if(outputRemainderSize) {
+                    if(*outputRemainderSize > minInputRemainderSize) {
+                        throw std::invalid_argument("The output of a merge cannot have larger remainders than its inputs");
+                    }
+                    return *outputRemainderSize;
+                }
+                std::uint64_t remainderSize = 0;
+                while(remainderSize < minInputRemainderSize && (inputs.at(0)->range >> (remainderSize+1)) >= totalCapacity) {
+                    remainderSize++;
+                }
+                return remainderSize;
+            }
+
+            //At least as large as the backyards of the inputs together, and as the backyard of a fresh filter of the output's capacity
+            static std::size_t mergedBackyardSize(const std::vector<const PartitionQuotientFilter*>& inputs, std::optional<std::uint64_t> outputRemainderSize) {
+                std::size_t totalBackyardSize = 0;
+                for(const PartitionQuotientFilter* input: inputs) {
+                    totalBackyardSize += input->backyard().size();
+                }
+                return std::max(totalBackyardSize, backyardSizeFor(inputs.at(0)->range >> mergedRemainderSize(inputs, outputRemainderSize)));
+            }
+
+            //Empty filter with an explicitly given geometry. Used for the outputs of the set operations
+            PartitionQuotientFilter(std::uint64_t realRemainderSize, std::size_t capacity, std::size_t range, std::size_t frontyardSize, std::size_t backyardSize):
+                RealRemainderSize{realRemainderSize},
+                HashMask{(1ull << RealRemainderSize) - 1},
+                capacity{capacity},
+                range{range},
+                frontyard(frontyardSize),
+                backyardBuckets(backyardSize)
+            {
+                R = backyardMappingR();
+            }
+
+            //The overflow of a frontyard bucket can fill every one of its backyard choices
+            static constexpr std::size_t MaxHashesPerFrontyardBucket = FrontyardBucketCapacity*(1 + SpillBits) + BackyardChoices*BackyardBucketCapacity;
+
+            //Walks a and b bucket-aligned like the merge does, sorts the hashes of each bucket (so sorted by mini bucket and then remainder), and calls emit(hash) for every distinct hash for which keep(inA, inB) is true.
+            //Returns the number of hashes emitted. Does not allocate.
+            template<typename Keep, typename Emit>
+            static std::size_t setOperation(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b, Keep keep, Emit emit) {
+                if(a.RealRemainderSize != b.RealRemainderSize || (a.capacity != b.capacity) || (a.range != b.range) || (a.frontyard.size() != b.frontyard.size())) {
+                    throw std::invalid_argument("Set operations must be between filters with the exact same properties");
+                }
+
+                std::array<std::uint64_t, MaxHashesPerFrontyardBucket> aHashes, bHashes;
+                std::size_t numAHashes, numBHashes;
+                auto addAHash = [&](std::uint64_t hash) {
+                    if constexpr (DEBUG) assert(numAHashes < MaxHashesPerFrontyardBucket);
+                    aHashes[numAHashes++] = hash;
+                };
+                auto addBHash = [&](std::uint64_t hash) {
+                    if constexpr (DEBUG) assert(numBHashes < MaxHashesPerFrontyardBucket);
+                    bHashes[numBHashes++] = hash;
+                };
+
+                std::size_t count = 0;
+                for(std::size_t i=0; i < a.frontyard.size(); i++) {
+                    numAHashes = 0;
+                    numBHashes = 0;
+                    a.forEachHashInFrontyardBucket(i, addAHash);
+                    b.forEachHashInFrontyardBucket(i, addBHash);
+                    std::sort(aHashes.begin(), aHashes.begin() + numAHashes);
+                    std::sort(bHashes.begin(), bHashes.begin() + numBHashes);
+
+                    std::size_t ai = 0, bi = 0;
+                    while(ai < numAHashes || bi < numBHashes) {
+                        std::uint64_t hash = std::min(ai < numAHashes ? aHashes[ai] : -1ull, bi < numBHashes ? bHashes[bi] : -1ull);
+                        bool inA = false, inB = false;
+                        for(; ai < numAHashes && aHashes[ai] == hash; ai++) inA = true;
+                        for(; bi < numBHashes && bHashes[bi] == hash; bi++) inB = true;
+                        if(keep(inA, inB)) {
+                            emit(hash);
+                            count++;
+                        }
+                    }
+                }
+                return count;
+            }
+
+            template<typename Keep>
+            static PartitionQuotientFilter setOperationFilter(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b, Keep keep, bool mergedGeometry) {
+                PartitionQuotientFilter out = mergedGeometry ? PartitionQuotientFilter(a.RealRemainderSize-1, a.capacity+b.capacity, a.range, a.frontyard.size()+b.frontyard.size(), a.backyard().size()+b.backyard().size())
+                                                             : PartitionQuotientFilter(a.RealRemainderSize, a.capacity, a.range, a.frontyard.size(), a.backyard().size());
+                setOperation(a, b, keep, [&out](std::uint64_t hash) {
+                    if(!out.insertInner(out.getQRPairFromHash(hash))) {
+                        throw std::runtime_error("Ran out of backyard space while building the result of a set operation");
+                    }
+                });
+                return out;
+            }
+
 
 
         public:
@@ -368,17 +1303,23 @@ namespace PQF {
             std::size_t range;
 
             PartitionQuotientFilter(std::size_t N, bool Normalize = true): 
-                RealRemainderSize{SizeRemainders},
-                HashMask{(1ull << SizeRemainders) - 1},
+                RealRemainderSize{SizeRemainders - SpillBits},
+                HashMask{(1ull << RealRemainderSize) - 1},
                 capacity{Normalize ? static_cast<size_t>(N/NormalizingFactor) : N},
-                range{capacity << SizeRemainders},
-                frontyard((capacity+BucketNumMiniBuckets-1)/BucketNumMiniBuckets),
-                backyard((frontyard.size()+FrontyardToBackyardRatio-1)/FrontyardToBackyardRatio + FrontyardToBackyardRatio*2)
+                range{capacity << RealRemainderSize},
+                frontyard(frontyardSizeFor(capacity)),
+                backyardBuckets(backyardSizeFor(capacity))
             {
-                R = frontyard.size() / FrontyardToBackyardRatio / FrontyardToBackyardRatio + 1;
-                if(R % (FrontyardToBackyardRatio - 1) == 0) R++;
+                R = backyardMappingR();
             }
 
+            //Filter for at least N keys that hashes into the given range, ex the range of another filter, so that filters of different sizes can later be merged together.
+            //Since capacity = range >> RealRemainderSize, the capacity gets rounded up to the range divided by a power of two, and the remainders lose a bit for every doubling of the capacity over that of the filter the range came from.
+            PartitionQuotientFilter(std::size_t N, std::size_t range, bool Normalize = true):
+                PartitionQuotientFilter(remainderSizeForRange(N, range, Normalize), range >> remainderSizeForRange(N, range, Normalize), range,
+                                        frontyardSizeFor(range >> remainderSizeForRange(N, range, Normalize)), backyardSizeFor(range >> remainderSizeForRange(N, range, Normalize)))
+            {}
+
 
              //create new PQF by merging
             PartitionQuotientFilter(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b, std::optional<std::vector<size_t>> verifykeys = {}) :
@@ -387,29 +1328,21 @@ namespace PQF {
                 capacity{a.capacity+b.capacity},
                 range{a.range},
                 frontyard(a.frontyard.size() + b.frontyard.size()),
-                backyard(a.backyard.size() + b.backyard.size())
+                backyardBuckets(a.backyard().size() + b.backyard().size())
             {
-                R = frontyard.size() / FrontyardToBackyardRatio / FrontyardToBackyardRatio + 1;
-                if(R % (FrontyardToBackyardRatio - 1) == 0) R++;
+                R = backyardMappingR();
                 
                 if(a.RealRemainderSize != b.RealRemainderSize || (a.capacity != b.capacity) || (a.range != b.range)) {
                     throw std::invalid_argument("Merges must be of filters with the exact same properties");
                 }
                 
 
-                std::vector<std::pair<uint64_t, uint64_t>> afrontkeys, bfrontkeys;
-                afrontkeys.reserve(FrontyardBucketCapacity);
-                bfrontkeys.reserve(FrontyardBucketCapacity);
-                std::vector<std::pair<uint64_t, uint64_t>> aback1keys, bback1keys;
-                std::vector<std::pair<uint64_t, uint64_t>> aback2keys, bback2keys;
-                aback1keys.reserve(BackyardBucketCapacity);
-                aback2keys.reserve(BackyardBucketCapacity);
-                bback1keys.reserve(BackyardBucketCapacity);
-                bback2keys.reserve(BackyardBucketCapacity);
-                std::vector<std::pair<uint64_t, uint64_t>> allKeys;
-                allKeys.reserve(2*FrontyardBucketCapacity + 4*BackyardBucketCapacity + 5);
-                // static constexpr size_t AllKeysSize = 2*FrontyardBucketCapacity + 4*BackyardBucketCapacity + 5;
-                // std::array<std::pair<uint64_t, uint64_t>, AllKeysSize> allKeys;
+                //Every hash of bucket i of a and b, wherever it is stored
+                std::vector<uint64_t> allKeys;
+                allKeys.reserve(2*MaxHashesPerFrontyardBucket);
+                auto addKey = [&allKeys](uint64_t hash) {
+                    allKeys.push_back(hash);
+                };
 
                 std::multiset<uint64_t> keyset;
                 if(verifykeys) {
@@ -420,46 +1353,11 @@ namespace PQF {
                 std::vector<uint64_t> insertedKeys;
 
                 for(size_t i=0; i < a.frontyard.size(); i++) {
-                    a.frontyard[i].deconstruct(afrontkeys);
-                    b.frontyard[i].deconstruct(bfrontkeys);
-                    
-                    FrontyardQRContainerType frontyardQR(i*BucketNumMiniBuckets, 0);
-#ifdef CUCKOO_HASH
-                    BackyardQRContainerType firstBackyardQR(frontyardQR, 0, a.R, backyard.size());
-                    BackyardQRContainerType secondBackyardQR(frontyardQR, 1, a.R, backyard.size());
-#else
-                    BackyardQRContainerType firstBackyardQR(frontyardQR, 0, a.R);
-                    BackyardQRContainerType secondBackyardQR(frontyardQR, 1, a.R);
-#endif
-
-                    a.backyard[firstBackyardQR.bucketIndex].deconstruct(aback1keys);
-                    b.backyard[firstBackyardQR.bucketIndex].deconstruct(bback1keys);
-                    a.backyard[secondBackyardQR.bucketIndex].deconstruct(aback2keys);
-                    b.backyard[secondBackyardQR.bucketIndex].deconstruct(bback2keys);
+                    a.forEachHashInFrontyardBucket(i, addKey);
+                    b.forEachHashInFrontyardBucket(i, addKey);
 
-                    auto filterbackyard = [&a] (auto& v, std::vector<std::pair<uint64_t, uint64_t>>& o, BackyardQRContainerType b) {
-                        for(auto x: v) {
-                            if((x.second & (~a.HashMask)) == b.remainder) {
-                                o.push_back(std::make_pair(x.first, x.second & a.HashMask));
-                            }
-                        }
-                    };
-
-                    allKeys.insert(allKeys.end(), afrontkeys.begin(), afrontkeys.end());
-                    allKeys.insert(allKeys.end(), bfrontkeys.begin(), bfrontkeys.end());
-
-                    filterbackyard(aback1keys, allKeys, firstBackyardQR);
-                    filterbackyard(bback1keys, allKeys, firstBackyardQR);
-                    filterbackyard(aback2keys, allKeys, secondBackyardQR);
-                    filterbackyard(bback2keys, allKeys, secondBackyardQR);
-
-                    FrontyardQRContainerType temp(0, 0);
                     for(size_t j=0; j < allKeys.size(); j++) {
-                        auto x = allKeys[j];
-                        if(x.first == BucketNumMiniBuckets) {
-                            continue;
-                        }
-                        uint64_t key = x.second + ((x.first + BucketNumMiniBuckets * i) << a.RealRemainderSize);
+                        uint64_t key = allKeys[j];
                         FrontyardQRContainerType frontyardQR = getQRPairFromHash(key);
                         if(verifykeys) {
                             insertedKeys.push_back(key);
@@ -483,12 +1381,6 @@ namespace PQF {
                         }
                     }
 
-                    afrontkeys.resize(0);
-                    bfrontkeys.resize(0);
-                    aback1keys.resize(0);
-                    aback2keys.resize(0);
-                    bback1keys.resize(0);
-                    bback2keys.resize(0);
                     allKeys.resize(0);
                 }
 
@@ -496,15 +1388,7 @@ namespace PQF {
                 std::shuffle(overflow.begin(), overflow.end(), generator);
                 for(size_t i=0; i < overflow.size(); i++) {
                     auto qr = overflow[i];
-#ifdef CUCKOO_HASH
-                    BackyardQRContainerType firstBackyardQR(qr, 0, R, backyard.size());
-                    BackyardQRContainerType secondBackyardQR(qr, 1, R, backyard.size());
-#else
-                    BackyardQRContainerType firstBackyardQR(qr, 0, R);
-                    BackyardQRContainerType secondBackyardQR(qr, 1, R);
-#endif
-
-                    if(!insertOverflow(qr, firstBackyardQR, secondBackyardQR)) {
+                    if(!placeOverflow(qr)) {
                         std::cerr << "Backyard merging failed" << std::endl;
                         exit(-1);
                     }
@@ -532,10 +1416,58 @@ namespace PQF {
                 }
             }
 
+            //create new PQF by merging any number of filters at once, ex for compacting many smaller filters into one. Merging 2^j equal filters is equivalent to j rounds of pairwise merging, but reads every input bucket exactly once.
+            //The inputs may have different capacities as long as they share the same range, so that they hash into the same space (ex the outputs of merges of different depths). Since capacity = range >> RealRemainderSize, their capacities differ by powers of two.
+            //By default the output gets the largest remainder size with which its capacity fits all the inputs' keys, but a smaller one can be asked for.
+            //The inputs are walked in lockstep over blocks of the hash space as large as a bucket of the input with the fewest buckets, so everything is sequential. Like the pairwise merge, overflow into the backyard is deferred and shuffled.
+            PartitionQuotientFilter(const std::vector<const PartitionQuotientFilter*>& inputs, std::optional<std::uint64_t> outputRemainderSize = {}) :
+                PartitionQuotientFilter(mergedRemainderSize(inputs, outputRemainderSize), inputs.at(0)->range >> mergedRemainderSize(inputs, outputRemainderSize), inputs.at(0)->range,
+                                        frontyardSizeFor(inputs.at(0)->range >> mergedRemainderSize(inputs, outputRemainderSize)), mergedBackyardSize(inputs, outputRemainderSize))
+            {
+                std::uint64_t maxInputRemainderSize = 0;
+                for(const PartitionQuotientFilter* input: inputs) {
+                    maxInputRemainderSize = std::max(maxInputRemainderSize, input->RealRemainderSize);
+                }
+
+                std::vector<FrontyardQRContainerType> overflow;
+                auto insertIntoFrontyard = [&](std::uint64_t hash) {
+                    FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
+                    FrontyardQRContainerType overflowQR = frontyard[frontyardQR.bucketIndex].insert(frontyardQR);
+                    if(overflowQR.miniBucketIndex != -1ull) {
+                        overflow.push_back(overflowQR);
+                    }
+                };
+                std::uint64_t blockSize = BucketNumMiniBuckets << maxInputRemainderSize;
+                for(std::uint64_t block = 0; block * blockSize < range; block++) {
+                    for(const PartitionQuotientFilter* input: inputs) {
+                        std::size_t bucketsPerBlock = 1ull << (maxInputRemainderSize - input->RealRemainderSize);
+                        std::size_t endBucket = std::min((block+1)*bucketsPerBlock, input->frontyard.size());
+                        for(std::size_t i = block*bucketsPerBlock; i < endBucket; i++) {
+                            input->forEachHashInFrontyardBucket(i, insertIntoFrontyard);
+                        }
+                    }
+                }
+
+                auto generator = std::mt19937_64(std::random_device()());
+                std::shuffle(overflow.begin(), overflow.end(), generator);
+                for(FrontyardQRContainerType qr: overflow) {
+                    if(!placeOverflow(qr)) {
+                        throw std::runtime_error("Ran out of backyard space while merging");
+                    }
+                }
+            }
+
             bool insert(std::uint64_t hash) {
                 FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
                 lockFrontyard(frontyardQR.bucketIndex);
 
+                if constexpr (EpochBits > 0) {
+                    tagWithEpoch(frontyardQR);
+                    if(frontyard[frontyardQR.bucketIndex].full()) { //Lazily make room from expired keys before overflowing into the backyard
+                        evictExpired(frontyardQR.bucketIndex);
+                    }
+                }
+
                 bool retval = insertInner(frontyardQR);
 
                 unlockFrontyard(frontyardQR.bucketIndex);
@@ -548,7 +1480,7 @@ namespace PQF {
                 for (size_t j=0; j < num_keys; j+=bsize) {
                     for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         FrontyardQRContainerType frontyardQR = getQRPairFromHash(hashes[i]);
-                        __builtin_prefetch(&frontyard[frontyardQR.bucketIndex]);
+                        prefetchFrontyard(frontyardQR.bucketIndex);
                     }
                     for(size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         status[i] = insert(hashes[i]);
@@ -556,18 +1488,61 @@ namespace PQF {
                 }
             }
 
+            //Inserts the key only if it is not already in the filter, atomically in the Threaded version. Returns 1 if the key was already there, 0 if it got inserted, 2 if it was not there and the insert failed.
+            //Costs about as much as a single query, since the insert goes where the query already looked
+            std::uint64_t insertIfAbsent(std::uint64_t hash) {
+                FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
+                lockFrontyard(frontyardQR.bucketIndex);
+
+                std::uint64_t retval = insertIfAbsentInner(frontyardQR);
+
+                unlockFrontyard(frontyardQR.bucketIndex);
+
+                return retval;
+            }
+
+            void insertIfAbsentBatch(const std::vector<size_t>& hashes, std::vector<std::uint64_t>& status, const uint64_t num_keys) {
+                constexpr size_t bsize = 16;
+                for (size_t j=0; j < num_keys; j+=bsize) {
+                    for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
+                        FrontyardQRContainerType frontyardQR = getQRPairFromHash(hashes[i]);
+                        prefetchFrontyard(frontyardQR.bucketIndex);
+                    }
+                    for(size_t i=j; i < std::min(num_keys, j+bsize); i++) {
+                        status[i] = insertIfAbsent(hashes[i]);
+                    }
+                }
+            }
+
             //also queries where the item is (backyard or frontyard)
             std::uint64_t queryWhere(std::uint64_t hash) {
                 FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
                 lockFrontyard(frontyardQR.bucketIndex);
 
-                std::uint64_t retval = queryWhereInner(frontyardQR);
+                std::uint64_t retval;
+                if constexpr (EpochBits > 0) {
+                    retval = queryWhereTaggedInner(frontyardQR);
+                }
+                else {
+                    retval = queryWhereInner(frontyardQR);
+                }
 
                 unlockFrontyard(frontyardQR.bucketIndex);
 
                 return retval;
             }
 
+            //Whether the overflow of the key's frontyard bucket has as many different backyard buckets to go to as it has choices. Without NEW_HASH, the choices of a few frontyard buckets are the same bucket, and those buckets run out of room well before the rest of the filter
+            bool backyardChoicesDistinct(std::uint64_t hash) {
+                BackyardQRs backyardQRs = getBackyardQRs(getQRPairFromHash(hash));
+                for(std::size_t k = 1; k < BackyardChoices; k++) {
+                    for(std::size_t j = 0; j < k; j++) {
+                        if(backyardQRs[j].bucketIndex == backyardQRs[k].bucketIndex) return false;
+                    }
+                }
+                return true;
+            }
+
             bool query(std::uint64_t hash) {
                 FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
                 lockFrontyard(frontyardQR.bucketIndex);
@@ -584,7 +1559,7 @@ namespace PQF {
                 for (size_t j=0; j < num_keys; j+=bsize) {
                     for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         FrontyardQRContainerType frontyardQR = getQRPairFromHash(hashes[i]);
-                        __builtin_prefetch(&frontyard[frontyardQR.bucketIndex]);
+                        prefetchFrontyard(frontyardQR.bucketIndex);
                     }
                     for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         status[i] = query(hashes[i]);
@@ -592,8 +1567,19 @@ namespace PQF {
                 }
             }
 
+            //Prefetches the frontyard bucket that hash maps to. Meant for overlapping the cache misses of several filters that get queried with the same hash
+            void prefetch(std::uint64_t hash) const {
+                prefetchFrontyard((hash >> RealRemainderSize) / BucketNumMiniBuckets);
+            }
+
+            //Empties the filter while keeping its geometry and memory
+            void clear() {
+                frontyard.clear();
+                backyard().clear();
+            }
+
             std::uint64_t sizeFilter()  {
-                return (frontyard.size()*sizeof(FrontyardBucketType)) + (backyard.size()*sizeof(BackyardBucketType));
+                return (frontyard.size()*sizeof(FrontyardBucketType)) + backyard().sizeInBytes();
             }
 
             bool remove(std::uint64_t hash) {
@@ -602,7 +1588,19 @@ namespace PQF {
                 FrontyardQRContainerType frontyardQR = getQRPairFromHash(hash);
                 lockFrontyard(frontyardQR.bucketIndex);
 
-                bool retval = removeInner(frontyardQR);
+                bool retval;
+                if constexpr (EpochBits > 0) { //Remove the newest live copy
+                    std::array<std::uint64_t, NumEpochTags> remainders;
+                    std::size_t numRemainders = getLiveRemainders(frontyardQR.remainder, remainders);
+                    retval = false;
+                    for(std::size_t j = 0; j < numRemainders && !retval; j++) {
+                        frontyardQR.remainder = remainders[j];
+                        retval = removeInner(frontyardQR);
+                    }
+                }
+                else {
+                    retval = removeInner(frontyardQR);
+                }
 
                 unlockFrontyard(frontyardQR.bucketIndex);
 
@@ -614,7 +1612,7 @@ namespace PQF {
                 for (size_t j=0; j < num_keys; j+=bsize) {
                     for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         FrontyardQRContainerType frontyardQR = getQRPairFromHash(hashes[i]);
-                        __builtin_prefetch(&frontyard[frontyardQR.bucketIndex]);
+                        prefetchFrontyard(frontyardQR.bucketIndex);
                     }
                     for (size_t i=j; i < std::min(num_keys, j+bsize); i++) {
                         status[i] = remove(hashes[i]);
@@ -623,12 +1621,139 @@ namespace PQF {
             }
 
             size_t getNumBuckets() {
-                return frontyard.size() + backyard.size();
+                return frontyard.size() + backyard().size();
+            }
+
+            //Calls f(hash) for every hash stored in the filter whose frontyard bucket is in [frontyardBegin, frontyardEnd), including the ones that overflowed into the backyard.
+            //Hashes come out bucket by bucket in increasing quotient order (though not sorted within a bucket), and nothing gets allocated. Since every hash is attributed to exactly one frontyard bucket, disjoint ranges enumerate disjoint sets of hashes.
+            //Does not lock anything, so do not run this concurrently with inserts or removes.
+            template<typename F>
+            void forEachHash(F f, std::size_t frontyardBegin = 0, std::size_t frontyardEnd = -1ull) const {
+                frontyardEnd = std::min(frontyardEnd, frontyard.size());
+                for(std::size_t i = frontyardBegin; i < frontyardEnd; i++) {
+                    forEachHashInFrontyardBucket(i, f);
+                }
+            }
+
+            //Splits the frontyard into numThreads contiguous ranges and enumerates each one on its own thread. Calls f(threadIndex, hash), so f gets called concurrently but any given threadIndex only ever comes from one thread
+            template<typename F>
+            void forEachHashParallel(F f, std::size_t numThreads) const {
+                std::vector<std::thread> threads;
+                std::size_t bucketsPerThread = (frontyard.size() + numThreads - 1) / numThreads;
+                for(std::size_t t = 0; t < numThreads; t++) {
+                    threads.push_back(std::thread([&, t] () {
+                        forEachHash([&](std::uint64_t hash) {f(t, hash);}, t*bucketsPerThread, (t+1)*bucketsPerThread);
+                    }));
+                }
+                for(auto& th: threads) {
+                    th.join();
+                }
+            }
+
+            //Set operations between two filters with the same properties (as required by the merge). Since a filter can only tell apart what it stores, these act on the stored hashes, so a hash is in the result of intersect if both filters store it, etc.
+            //Duplicates are collapsed, so the outputs hold every hash once. intersect and difference return a filter with the same geometry as a, while unionDistinct returns one with the geometry of the merge of a and b.
+            static PartitionQuotientFilter intersect(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperationFilter(a, b, [](bool inA, bool inB) {return inA && inB;}, false);
+            }
+
+            static PartitionQuotientFilter difference(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperationFilter(a, b, [](bool inA, bool inB) {return inA && !inB;}, false);
+            }
+
+            static PartitionQuotientFilter unionDistinct(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperationFilter(a, b, [](bool inA, bool inB) {return inA || inB;}, true);
+            }
+
+            //Just the sizes of the above without building anything, ex for a cheap Jaccard-style overlap estimate of intersectSize/unionDistinctSize
+            static std::size_t intersectSize(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperation(a, b, [](bool inA, bool inB) {return inA && inB;}, [](std::uint64_t) {});
+            }
+
+            static std::size_t differenceSize(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperation(a, b, [](bool inA, bool inB) {return inA && !inB;}, [](std::uint64_t) {});
+            }
+
+            static std::size_t unionDistinctSize(const PartitionQuotientFilter& a, const PartitionQuotientFilter& b) {
+                return setOperation(a, b, [](bool inA, bool inB) {return inA || inB;}, [](std::uint64_t) {});
+            }
+
+            //Per entry expiry, only available with EpochBits > 0. Keys inserted in some epoch stay for ttlEpochs epochs (including that one), so ex with ttlEpochs = 1 only the keys inserted in the current epoch are live.
+            //Expired keys stop matching immediately, and their slots get reclaimed either lazily when inserting into a full bucket or by sweep.
+            void setTTL(std::uint64_t epochs) {
+                static_assert(EpochBits > 0, "Expiry needs epoch tags");
+                if(epochs == 0 || epochs >= NumEpochTags) {
+                    throw std::invalid_argument("The TTL must be between 1 and 2^EpochBits - 1 epochs");
+                }
+                ttlEpochs = epochs;
+            }
+
+            std::uint64_t getEpoch() const {
+                return currentEpoch;
+            }
+
+            //Evicts the expired keys of the next numFrontyardBuckets frontyard buckets (and what they overflowed into the backyard), wrapping around at the end. Meant to be called incrementally, ex from a background thread in the Threaded version
+            void sweep(std::size_t numFrontyardBuckets) {
+                static_assert(EpochBits > 0, "Expiry needs epoch tags");
+                for(; numFrontyardBuckets > 0; numFrontyardBuckets--) {
+                    if(sweepCursor == 0) {
+                        sweepStartEpoch = currentEpoch;
+                    }
+                    lockFrontyard(sweepCursor);
+                    evictExpired(sweepCursor);
+                    unlockFrontyard(sweepCursor);
+                    sweepCursor++;
+                    if(sweepCursor == frontyard.size()) {
+                        sweepCursor = 0;
+                        lastCompletedSweepStart = sweepStartEpoch;
+                    }
+                }
+            }
+
+            //Starts the next epoch. Not safe to call concurrently with other operations.
+            //The tag of the new epoch was last used NumEpochTags epochs ago, and those keys expired ttlEpochs epochs after that, so a full sweep that started since then must have finished. If sweep was not called often enough, this finishes one here
+            void advanceEpoch() {
+                static_assert(EpochBits > 0, "Expiry needs epoch tags");
+                std::uint64_t nextEpoch = currentEpoch + 1;
+                if(nextEpoch >= NumEpochTags) {
+                    std::uint64_t requiredSweepStart = nextEpoch - NumEpochTags + ttlEpochs;
+                    if(lastCompletedSweepStart < requiredSweepStart) {
+                        if(sweepCursor == 0 || sweepStartEpoch < requiredSweepStart) {
+                            sweepCursor = 0;
+                            sweep(frontyard.size());
+                        }
+                        else {
+                            sweep(frontyard.size() - sweepCursor);
+                        }
+                    }
+                }
+                currentEpoch = nextEpoch;
+            }
+
+            std::size_t getNumFrontyardBuckets() const {
+                return frontyard.size();
             }
         
         private:
-            AlignedVector<FrontyardBucketType, 64> frontyard;
-            AlignedVector<BackyardBucketType, 64> backyard;
+            static constexpr bool Interleaved = Layout == BucketLayout::Interleaved;
+            using InterleavedBucketsType = InterleavedBuckets<FrontyardBucketType, BackyardBucketType, FrontyardToBackyardRatio>;
+            //Stands in for the backyard of an interleaved filter, which lives in the frontyard
+            struct NoBackyardBuckets {
+                NoBackyardBuckets(std::size_t) {}
+            };
+
+            std::conditional_t<Interleaved, InterleavedBucketsType, AlignedVector<FrontyardBucketType, std::max<std::size_t>(FrontyardBucketSize, 64)>> frontyard;
+            //The backyard only gets written to when a frontyard bucket overflows, so at low load most of it can stay unallocated
+            [[no_unique_address]] std::conditional_t<Interleaved, NoBackyardBuckets, std::conditional_t<LazyBackyard, LazyAlignedVector<BackyardBucketType, 64>, AlignedVector<BackyardBucketType, 64>>> backyardBuckets;
+
+            inline decltype(auto) backyard() {
+                if constexpr (Interleaved) return frontyard.backyard();
+                else return (backyardBuckets);
+            }
+
+            inline decltype(auto) backyard() const {
+                if constexpr (Interleaved) return frontyard.backyard();
+                else return (backyardBuckets);
+            }
 
     };
 
@@ -651,6 +1776,56 @@ namespace PQF {
     using PQF_16_36 = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false>;
     using PQF_16_36_FRQ = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, true, false>;
 
+    //The other remainder widths, in the geometries OptimalGeometry picks for 64 byte buckets. 5 to 12 bits use the packed store, 20 to 32 bits are split into 16, 8 and 4 bit pieces.
+    using PQF_5_65 = PartitionQuotientFilter<5, 65, 63, 44, 8, 64, 64, false, false>;
+    using PQF_6_65 = PartitionQuotientFilter<6, 65, 63, 40, 8, 64, 64, false, false>;
+    using PQF_7_64 = PartitionQuotientFilter<7, 64, 56, 36, 8, 64, 64, false, false>;
+    using PQF_10_37 = PartitionQuotientFilter<10, 37, 43, 31, 8, 64, 64, false, false>;
+    using PQF_12_44 = PartitionQuotientFilter<12, 44, 36, 27, 8, 64, 64, false, false>;
+    using PQF_20_25 = PartitionQuotientFilter<20, 25, 23, 19, 6, 64, 64, false, false>;
+    using PQF_24_12 = PartitionQuotientFilter<24, 12, 20, 16, 6, 64, 64, false, false>;
+    using PQF_32_17 = PartitionQuotientFilter<32, 17, 15, 13, 5, 64, 64, false, false>;
+
+
+    //Entries carry a 3 bit epoch tag for per entry expiry, leaving 13 bit fingerprints
+    using PQF_16_36_TTL = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false, 3>;
+    using PQF_16_35_TTL_T = PartitionQuotientFilter<16, 35, 28, 22, 8, 64, 64, false, true, 3>;
+
+    //Backyard allocated a page at a time as frontyard buckets overflow into it, for filters that spend most of their time at low load
+    using PQF_8_22_LAZY = PartitionQuotientFilter<8, 22, 26, 18, 8, 32, 32, false, false, 0, true>;
+    using PQF_16_36_LAZY = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false, 0, true>;
+    using PQF_8_21_LAZY_T = PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, false, true, 0, true>;
+
+    //Mini filter select without BMI2's pdep, for CPUs where it is microcoded (AMD before Zen 3)
+    using PQF_8_22_BWS = PartitionQuotientFilter<8, 22, 26, 18, 8, 32, 32, false, false, 0, false, SelectType::Broadword>;
+    using PQF_8_53_BWS = PartitionQuotientFilter<8, 53, 51, 35, 8, 64, 64, false, false, 0, false, SelectType::Broadword>;
+    using PQF_16_36_BWS = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false, 0, false, SelectType::Broadword>;
+
+    //Full frontyard buckets spill over into their partner bucket before the backyard, for a higher load and fewer backyard lookups at the cost of one bit of fingerprint
+    using PQF_8_22_2C = PartitionQuotientFilter<8, 22, 26, 18, 8, 32, 32, false, false, 0, false, SelectType::Pdep, FrontyardSpill::Partner>;
+    using PQF_8_53_2C = PartitionQuotientFilter<8, 53, 51, 35, 8, 64, 64, false, false, 0, false, SelectType::Pdep, FrontyardSpill::Partner>;
+    using PQF_16_36_2C = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false, 0, false, SelectType::Pdep, FrontyardSpill::Partner>;
+
+    //Same, but the 32 byte frontyard buckets spill over into the other half of their cacheline
+    using PQF_8_22_SIB = PartitionQuotientFilter<8, 22, 26, 18, 8, 32, 32, false, false, 0, false, SelectType::Pdep, FrontyardSpill::Sibling>;
+    using PQF_8_22BB_SIB = PartitionQuotientFilter<8, 22, 26, 37, 8, 32, 64, false, false, 0, false, SelectType::Pdep, FrontyardSpill::Sibling>;
+    using PQF_8_21_SIB_T = PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, false, true, 0, false, SelectType::Pdep, FrontyardSpill::Sibling>;
+
+    //Three and four backyard buckets to pick the emptiest of rather than two. The backyard tag gets a bit wider, which costs the backyard buckets two keys with 8 bit remainders and one with 16 bit ones
+    using PQF_8_22_D3 = PartitionQuotientFilter<8, 22, 26, 16, 8, 32, 32, false, false, 0, false, SelectType::Pdep, FrontyardSpill::None, 3>;
+    using PQF_8_22_D4 = PartitionQuotientFilter<8, 22, 26, 16, 8, 32, 32, false, false, 0, false, SelectType::Pdep, FrontyardSpill::None, 4>;
+    using PQF_16_36_D4 = PartitionQuotientFilter<16, 36, 28, 21, 8, 64, 64, false, false, 0, false, SelectType::Pdep, FrontyardSpill::None, 4>;
+    using PQF_8_21_D4_T = PartitionQuotientFilter<8, 21, 26, 16, 8, 32, 32, false, true, 0, false, SelectType::Pdep, FrontyardSpill::None, 4>;
+
+    //Backyard buckets interleaved with the frontyard, so that going to the backyard stays on the huge page of the frontyard bucket
+    using PQF_8_22_IL = PartitionQuotientFilter<8, 22, 26, 18, 8, 32, 32, false, false, 0, false, SelectType::Pdep, FrontyardSpill::None, 2, BucketLayout::Interleaved>;
+    using PQF_16_36_IL = PartitionQuotientFilter<16, 36, 28, 22, 8, 64, 64, false, false, 0, false, SelectType::Pdep, FrontyardSpill::None, 2, BucketLayout::Interleaved>;
+    using PQF_8_21_IL_T = PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, false, true, 0, false, SelectType::Pdep, FrontyardSpill::None, 2, BucketLayout::Interleaved>;
+
+    //128 byte frontyard buckets spanning two cachelines, in the geometry OptimalGeometry picks for them: more keys per bucket, so fewer overflow to the backyard, and less space per key than PQF_16_36
+    using PQF_16_55_128 = PartitionQuotientFilter<16, 55, 57, 21, 5, 128, 64, false, false>;
+    using PQF_16_55_128_FRQ = PartitionQuotientFilter<16, 55, 57, 21, 5, 128, 64, true, false>;
+    using PQF_16_54_128_T = PartitionQuotientFilter<16, 54, 57, 21, 5, 128, 64, false, true>;
 
     using PQF_8_21_T = PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, false, true>;
     using PQF_8_21_FRQ_T = PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, true, true>;
@@ -661,5 +1836,6 @@ namespace PQF {
     using PQF_16_35_T = PartitionQuotientFilter<16, 35, 28, 22, 8, 64, 64, false, true>;
     using PQF_16_35_FRQ_T = PartitionQuotientFilter<16, 35, 28, 22, 8, 64, 64, false, true>;
 }
+}
 
 #endif
@@ -3,9 +3,12 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <immintrin.h>
+#include <algorithm>
+#include <bit>
+#include "TestUtility.hpp"
 
 namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
     //Just a data structure to store bucket index, mini bucket index, and remainder trios
     //And also then allow you to get the same for the backyard/attic
     //Just use the global settings in Configuration.hpp for NumMiniBuckets?
@@ -22,10 +25,15 @@ namespace PQF {
     };
 
     //Consolidation bits is how many bits we use to refer to which bucket an item came from, one bit of which is used to specify the hashnum.
-    template<std::size_t NumMiniBuckets, std::size_t RemainderBits, std::size_t ConsolidationFactor>
+    //NumChoices is how many backyard buckets a frontyard bucket can overflow into. The first two come from the two hashes, and the third and fourth are the first and second moved half the backyard along (moveToUpperHalf).
+    template<std::size_t NumMiniBuckets, std::size_t RemainderBits, std::size_t ConsolidationFactor, std::size_t NumChoices = 2>
     struct BackyardQRContainer {
-        // static const std::size_t ConsolidationFactorP2 = 1ull << (64-_lzcnt_u64(ConsolidationFactor-1));
-        static constexpr std::size_t ConsolidationFactorP2 = 8; //Why can I not do this as in the above to do it dynamically? So frustrating. Like sure *maybe* I technically don't need it *right now,* but I really don't like having this fixed constant here. Like obviously I get it lzcnt is not a constexpr function, but like *why* is it not a constexpr function, and fine if its not constexpr like whatever, why does static const get typecast to static constexpr for no reason? Can I not initialize it when running the program then wtf?
+        static_assert(ConsolidationFactor >= 2);
+        static_assert(NumChoices >= 2 && NumChoices <= 4);
+        //The tag of a backyard key is which of the ConsolidationFactor frontyard buckets sharing its backyard bucket it came from, plus ConsolidationFactorP2 for the second hash (and 2*ConsolidationFactorP2 for the moved choices), so it takes TagBits bits.
+        //Never less than 4 bits, so that ratios up to 8 keep the layout they always had.
+        static constexpr std::size_t ConsolidationFactorP2 = std::max<std::size_t>(8, std::bit_ceil(ConsolidationFactor));
+        static constexpr std::size_t TagBits = std::countr_zero(ConsolidationFactorP2) + std::bit_width(NumChoices - 1);
         // std::size_t quotient; // Do we really need to store this?
         std::size_t realRemainder; //We imbue the remainder with the hash to make a bigger remainder, so this is just to store what was originally the remainder before the addition. Not used but just to be there
         std::size_t bucketIndex;
@@ -37,10 +45,10 @@ namespace PQF {
             if (hashNum) {
                 whichFrontyardBucket = (frontyardBucketIndex % ConsolidationFactor) + ConsolidationFactorP2;
                 if constexpr (DEBUG)
-                    assert(whichFrontyardBucket < 16);
+                    assert(whichFrontyardBucket < 2*ConsolidationFactorP2);
                 bucketIndex = frontyardBucketIndex / ConsolidationFactor;
                 // todo why is this required?
-                remainder += whichFrontyardBucket << RemainderBits;
+                remainder += static_cast<std::uint64_t>(whichFrontyardBucket) << RemainderBits;
             }
             else {
                 std::uint64_t fbiMinusLowBits = frontyardBucketIndex / ConsolidationFactor; // f2
@@ -60,7 +68,7 @@ namespace PQF {
                     assert(whichFrontyardBucket < ConsolidationFactorP2);
                     assert(fbiMinusLowBits/ConsolidationFactor < R);
                 }
-                remainder += whichFrontyardBucket << RemainderBits;
+                remainder += static_cast<std::uint64_t>(whichFrontyardBucket) << RemainderBits;
             }
         }
 
@@ -87,6 +95,8 @@ whichFrontyardBucket = fbiMinusLowBits % ConsolidationFactor;
             }
         }
 
+        inline BackyardQRContainer() = default;
+
         inline BackyardQRContainer(std::size_t quotient, std::uint64_t remainder, bool hashNum, std::uint64_t R): /*quotient{quotient},*/ realRemainder{remainder}, miniBucketIndex{quotient%NumMiniBuckets}, remainder(remainder) {
             std::uint64_t frontyardBucketIndex = quotient/NumMiniBuckets;
             finishInit(frontyardBucketIndex, hashNum, R);
@@ -104,8 +114,16 @@ whichFrontyardBucket = fbiMinusLowBits % ConsolidationFactor;
             finishInit(frontQR.bucketIndex, hashNum, R);
         }
 #endif
+
+        //Turns choice 0 or 1 into choice 2 or 3. The top bit of the tag tells them apart, so two choices landing in the same backyard bucket never mix up their keys.
+        inline void moveToUpperHalf(std::size_t backyardSize) {
+            bucketIndex = (bucketIndex + backyardSize/2) % backyardSize;
+            whichFrontyardBucket += 2*ConsolidationFactorP2;
+            remainder += static_cast<std::uint64_t>(2*ConsolidationFactorP2) << RemainderBits;
+        }
     };
 
 }
+}
 
 #endif
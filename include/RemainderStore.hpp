@@ -6,13 +6,14 @@
 #include <cstring>
 #include <utility>
 #include <algorithm>
-#include <immintrin.h>
+#include <array>
 #include <cassert>
 #include "TestUtility.hpp"
 #include <bit>
 
 namespace PQF {
-    //All of these only work with 32 or 64 byte buckets. Not the best design I know, but it implicitly uses the bucket size to determine its pointer and to know what size AVX512 unit to fetch.
+inline namespace PQF_ISA_NAMESPACE {
+    //All of these only work with 32 or 64 byte buckets (and 128 byte ones for the 16 bit store). Not the best design I know, but it implicitly uses the bucket size to determine its pointer and to know what size AVX512 unit to fetch.
 
     template<std::size_t RemainderSize, std::size_t NumRemainders, std::size_t Offset>
     struct alignas(1) RemainderStore {
@@ -48,7 +49,8 @@ namespace PQF {
         inline static constexpr bool CanSplit = false;
 
         using StoreFirstType = RemainderStore<SizeFirst, NumRemainders, Offset>;
-        inline static constexpr std::size_t TotalSizeFirst = StoreFirstType::Size;
+        //sizeof rather than Size: a first piece that contains a 16 bit store is 2 byte aligned, so with an odd Size (like the 24 bit store with an odd number of remainders) it gets padded
+        inline static constexpr std::size_t TotalSizeFirst = sizeof(StoreFirstType);
         using StoreSecondType = RemainderStore<SizeSecond, NumRemainders, Offset+TotalSizeFirst>;
         inline static constexpr std::size_t TotalSizeSecond = StoreSecondType::Size;
         inline static constexpr std::size_t Size = TotalSizeFirst+TotalSizeSecond;
@@ -64,8 +66,8 @@ namespace PQF {
 
             uint64_t remainderFirstPart = remainder & ((1ull << SizeFirst) - 1);
             uint64_t remainderSecondPart = remainder >> SizeFirst;
-            uint64_t overflow = storeFirstPart.insert(remainderFirstPart, loc) << 4ull;
-            overflow |= storeSecondPart.insert(remainderSecondPart, loc);
+            uint64_t overflow = storeFirstPart.insert(remainderFirstPart, loc);
+            overflow |= static_cast<std::uint64_t>(storeSecondPart.insert(remainderSecondPart, loc)) << SizeFirst;
             return overflow;
         }
 
@@ -99,7 +101,7 @@ namespace PQF {
         }
 
         //This is really just adhoc stuff to get the deletions to work, so that we find where the keys are that match the bucket we're coming from
-        inline std::uint64_t query4BitPartMask(std::uint_fast8_t bits, std::uint64_t mask) {
+        inline std::uint64_t querySecondPartMask(std::uint64_t bits, std::uint64_t mask) {
             return storeSecondPart.queryVectorizedMask(bits, mask);
         }
 
@@ -116,7 +118,7 @@ namespace PQF {
     };
 
 
-    #ifdef __AVX512BW__
+    #if PQF_AVX512
 
     struct alignas(64) m512iWrapper {
         static constexpr __m512i zero = {0, 0, 0, 0, 0, 0, 0, 0};
@@ -134,6 +136,12 @@ namespace PQF {
         std::array<std::uint8_t, NumRemainders> remainders;
 
         inline static constexpr __mmask64 StoreMask = (NumRemainders + Offset < 64) ? ((1ull << (NumRemainders+Offset)) - (1ull << Offset)) : (-(1ull << Offset));
+        inline static constexpr __mmask64 EndMask = (NumRemainders + Offset < 64) ? ((1ull << (NumRemainders+Offset)) - 1) : -1ull;
+
+        //The byte of remainder loc, or nothing if loc is one past the end of the store (where insert is a no op)
+        inline static __mmask64 getLocMask(std::size_t loc) {
+            return _bzhi_u64(EndMask, loc + Offset + 1) ^ _bzhi_u64(EndMask, loc + Offset);
+        }
 
         inline __m512i* getNonOffsetBucketAddress2() {
             return reinterpret_cast<__m512i*>(reinterpret_cast<std::uint8_t*>(&remainders) - Offset);
@@ -221,8 +229,16 @@ namespace PQF {
             std::uint_fast8_t retval = remainders[NumRemainders-1];
 
             __m512i packedStore = loadRemainders();
-            __m512i packedStoreWithRemainder = _mm512_mask_set1_epi8(packedStore, 1, remainder);
-            packedStore = _mm512_mask_permutexvar_epi8(packedStore, StoreMask, shuffleVectors[loc], packedStoreWithRemainder);
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                __m512i packedStoreWithRemainder = _mm512_mask_set1_epi8(packedStore, 1, remainder);
+                packedStore = _mm512_mask_permutexvar_epi8(packedStore, StoreMask, shuffleVectors[loc], packedStoreWithRemainder);
+            }
+            else {
+                //Expanding into every byte below the end of the store but loc moves everything from loc on up one, and loc gets the remainder from the source
+                __mmask64 locMask = getLocMask(loc);
+                __m512i packedStoreWithRemainder = _mm512_mask_set1_epi8(packedStore, locMask, remainder);
+                packedStore = _mm512_mask_expand_epi8(packedStoreWithRemainder, EndMask & ~locMask, packedStore);
+            }
             storeRemainders(packedStore);
 
             return retval;
@@ -230,7 +246,13 @@ namespace PQF {
 
         inline void remove(std::size_t loc) {
             __m512i packedStore = loadRemainders();
-            packedStore = _mm512_mask_permutexvar_epi8(packedStore, StoreMask, removeShuffleVectors[loc], packedStore);
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                packedStore = _mm512_mask_permutexvar_epi8(packedStore, StoreMask, removeShuffleVectors[loc], packedStore);
+            }
+            else {
+                //Compressing out loc moves everything after it down one; the last slot and everything past the store keep their old bytes
+                packedStore = _mm512_mask_compress_epi8(packedStore, EndMask & ~getLocMask(loc), packedStore);
+            }
             storeRemainders(packedStore);
         }
 
@@ -392,6 +414,26 @@ namespace PQF {
 
         inline static constexpr std::array<m512iWrapper, 64> packedStoreMasks = getPackedStoreMasks();
 
+        //Same as the tables above, built in registers: every bit before remainder loc, and the bits of remainder loc
+        inline static __m512i packedStoreMask(std::size_t loc) {
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                return packedStoreMasks[loc];
+            }
+            else {
+                std::size_t byteIndex = (loc >> 1) + Offset;
+                return _mm512_mask_set1_epi8(_mm512_maskz_set1_epi8((1ull << byteIndex) - 1, -1), 1ull << byteIndex, (loc & 1) * 15);
+            }
+        }
+
+        inline static __m512i remainderStoreMask(std::size_t loc) {
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                return remainderStoreMasks[loc];
+            }
+            else {
+                return _mm512_maskz_set1_epi8(1ull << ((loc >> 1) + Offset), 15 << ((loc & 1)*4));
+            }
+        }
+
         inline static void set4Bits(std::uint_fast8_t& byte, std::uint_fast8_t bitGroup, std::uint_fast8_t bits) {
             if constexpr (DEBUG) assert(bitGroup <= 1 && bits < 16);
             byte = (byte & (0b1111 << ((1-bitGroup)*4))) + (bits << (bitGroup*4));
@@ -412,8 +454,8 @@ namespace PQF {
             __m512i shuffleMoveRight = {7, 0, 1, 2, 3, 4, 5, 6};
             __m512i packedStoreShiftedRight = _mm512_permutexvar_epi64(shuffleMoveRight, packedStore);
             __m512i packedStoreShiftedRight4Bits = _mm512_shldi_epi64(packedStore, packedStoreShiftedRight, 4); //Yes this says shldi which is left shift and well we are doing a left shift but that's in big endian, and well when I work with intrinsics I start thinking little endian.
-            __m512i newPackedStore = _mm512_ternarylogic_epi32(packedStoreShiftedRight4Bits, packedStore, packedStoreMasks[loc], 0b11011000);
-            newPackedStore = _mm512_ternarylogic_epi32(newPackedStore, packedRemainders, remainderStoreMasks[loc], 0b11011000);
+            __m512i newPackedStore = _mm512_ternarylogic_epi32(packedStoreShiftedRight4Bits, packedStore, packedStoreMask(loc), 0b11011000);
+            newPackedStore = _mm512_ternarylogic_epi32(newPackedStore, packedRemainders, remainderStoreMask(loc), 0b11011000);
             storeRemainders(_mm512_mask_blend_epi8(StoreMask, packedStore, newPackedStore));
             return retval;
         }
@@ -423,7 +465,7 @@ namespace PQF {
             __m512i shuffleMoveLeft = {1, 2, 3, 4, 5, 6, 7, 0};
             __m512i packedStoreShiftedLeft = _mm512_permutexvar_epi64(shuffleMoveLeft, packedStore);
             __m512i packedStoreShiftedLeft4Bits = _mm512_shrdi_epi64(packedStore, packedStoreShiftedLeft, 4);
-            __m512i newPackedStore = _mm512_ternarylogic_epi32(packedStoreShiftedLeft4Bits, packedStore, packedStoreMasks[loc], 0b11011000);
+            __m512i newPackedStore = _mm512_ternarylogic_epi32(packedStoreShiftedLeft4Bits, packedStore, packedStoreMask(loc), 0b11011000);
             storeRemainders(_mm512_mask_blend_epi8(StoreMask, packedStore, newPackedStore));
         }
 
@@ -500,9 +542,6 @@ namespace PQF {
         }
     };
 
-    template<std::size_t NumRemainders, std::size_t Offset>
-    struct alignas(1) RemainderStore<12, NumRemainders, Offset> : RemainderStoreTwoPieces<8, 4, NumRemainders, Offset>{};
-
     //Requires the remainder to be aligned to two byte boundary, as otherwise could not use the 2-byte __AVX512BW__ instruction and would be inneficient
     template<std::size_t NumRemainders, std::size_t Offset>
     struct alignas(1) RemainderStore<16, NumRemainders, Offset> {
@@ -515,7 +554,17 @@ namespace PQF {
 
         inline static constexpr size_t WordOffset = Offset/2;
 
+        //128 byte buckets: the store runs past the first cacheline, so it is kept in two vectors, one per cacheline, and an element is carried from the first into the second on insert (and back on remove)
+        inline static constexpr bool TwoCachelines = Offset + Size > 64;
+        static_assert(Offset + Size <= 128);
+        inline static constexpr __mmask32 HighEndMask = TwoCachelines ? ((Offset + Size < 128) ? ((1u << (NumRemainders+WordOffset-32)) - 1) : -1u) : 0;
+
         inline static constexpr __mmask32 StoreMask = (NumRemainders + WordOffset < 32) ? ((1u << (NumRemainders+WordOffset)) - (1u << WordOffset)) : (-(1u << WordOffset));
+        inline static constexpr __mmask32 EndMask = (NumRemainders + WordOffset < 32) ? ((1u << (NumRemainders+WordOffset)) - 1) : -1u;
+
+        inline static __mmask32 getLocMask(std::size_t loc) {
+            return _bzhi_u32(EndMask, loc + WordOffset + 1) ^ _bzhi_u32(EndMask, loc + WordOffset);
+        }
 
         inline __m512i* getNonOffsetBucketAddress2() {
             return reinterpret_cast<__m512i*>(reinterpret_cast<std::uint8_t*>(&remainders) - Offset);
@@ -601,17 +650,73 @@ namespace PQF {
             }
             std::uint_fast16_t retval = remainders[NumRemainders-1];
 
+            if constexpr (TwoCachelines) {
+                insertTwoCachelines(remainder, loc);
+                return retval;
+            }
+
             __m512i packedStore = loadRemainders();
-            __m512i packedStoreWithRemainder = _mm512_mask_set1_epi16(packedStore, 1, remainder);
-            packedStore = _mm512_mask_permutexvar_epi16(packedStore, StoreMask, shuffleVectors[loc], packedStoreWithRemainder);
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                __m512i packedStoreWithRemainder = _mm512_mask_set1_epi16(packedStore, 1, remainder);
+                packedStore = _mm512_mask_permutexvar_epi16(packedStore, StoreMask, shuffleVectors[loc], packedStoreWithRemainder);
+            }
+            else {
+                __mmask32 locMask = getLocMask(loc);
+                __m512i packedStoreWithRemainder = _mm512_mask_set1_epi16(packedStore, locMask, remainder);
+                packedStore = _mm512_mask_expand_epi16(packedStoreWithRemainder, EndMask & ~locMask, packedStore);
+            }
             storeRemainders(packedStore);
 
             return retval;
         }
 
+        //The tables only cover one vector, so this is always expand (and compress in removeTwoCachelines)
+        inline void insertTwoCachelines(std::uint_fast16_t remainder, std::size_t loc) {
+            __m512i* bucket = getNonOffsetBucketAddress2();
+            __m512i low = _mm512_load_si512(bucket);
+            __m512i high = _mm512_load_si512(bucket + 1);
+            std::size_t pos = loc + WordOffset;
+            std::uint64_t locMask = 1ull << pos;
+            __mmask32 lowLocMask = static_cast<std::uint32_t>(locMask);
+            //If the remainder goes in the low half, the last element of the low half gets inserted at the start of the high half instead
+            bool inLow = pos < 32;
+            __mmask32 highLocMask = (static_cast<std::uint32_t>(locMask >> 32) & HighEndMask) | inLow;
+            std::uint_fast16_t highValue = inLow ? reinterpret_cast<std::uint16_t*>(bucket)[31] : remainder;
+            low = _mm512_mask_expand_epi16(_mm512_mask_set1_epi16(low, lowLocMask, remainder), ~lowLocMask, low);
+            high = _mm512_mask_expand_epi16(_mm512_mask_set1_epi16(high, highLocMask, highValue), HighEndMask & ~highLocMask, high);
+            _mm512_store_si512(bucket, low);
+            _mm512_store_si512(bucket + 1, high);
+        }
+
+        inline void removeTwoCachelines(std::size_t loc) {
+            __m512i* bucket = getNonOffsetBucketAddress2();
+            __m512i low = _mm512_load_si512(bucket);
+            __m512i high = _mm512_load_si512(bucket + 1);
+            std::size_t pos = loc + WordOffset;
+            std::uint64_t locMask = 1ull << pos;
+            __mmask32 lowLocMask = static_cast<std::uint32_t>(locMask);
+            bool inLow = pos < 32;
+            __mmask32 highLocMask = (static_cast<std::uint32_t>(locMask >> 32) & HighEndMask) | inLow;
+            std::uint_fast16_t carried = reinterpret_cast<std::uint16_t*>(bucket)[32];
+            low = _mm512_mask_compress_epi16(low, ~lowLocMask, low);
+            low = _mm512_mask_set1_epi16(low, static_cast<std::uint32_t>(inLow) << 31, carried);
+            high = _mm512_mask_compress_epi16(high, HighEndMask & ~highLocMask, high);
+            _mm512_store_si512(bucket, low);
+            _mm512_store_si512(bucket + 1, high);
+        }
+
         inline void remove(std::size_t loc) {
+            if constexpr (TwoCachelines) {
+                removeTwoCachelines(loc);
+                return;
+            }
             __m512i packedStore = loadRemainders();
-            packedStore = _mm512_mask_permutexvar_epi16(packedStore, StoreMask, removeShuffleVectors[loc], packedStore);
+            if constexpr (PQF_REMAINDER_STORE_TABLES) {
+                packedStore = _mm512_mask_permutexvar_epi16(packedStore, StoreMask, removeShuffleVectors[loc], packedStore);
+            }
+            else {
+                packedStore = _mm512_mask_compress_epi16(packedStore, EndMask & ~getLocMask(loc), packedStore);
+            }
             storeRemainders(packedStore);
         }
 
@@ -642,13 +747,27 @@ namespace PQF {
             return retMask;
         }
 
+        inline std::uint64_t queryTwoCachelines(std::uint_fast16_t remainder) {
+            __m512i* bucket = getNonOffsetBucketAddress2();
+            __m512i remainderVec = _mm512_set1_epi16(remainder);
+            std::uint64_t lowMatches = _cvtmask32_u32(_mm512_cmpeq_epu16_mask(_mm512_load_si512(bucket), remainderVec));
+            std::uint64_t highMatches = _cvtmask32_u32(_mm512_cmpeq_epu16_mask(_mm512_load_si512(bucket + 1), remainderVec));
+            return (lowMatches | (highMatches << 32)) >> WordOffset;
+        }
+
         inline std::uint64_t queryVectorizedMask(std::uint_fast16_t remainder, std::uint64_t mask) {
+            if constexpr (TwoCachelines) {
+                return queryTwoCachelines(remainder) & mask;
+            }
             __m512i packedStore = loadRemainders();
             __m512i remainderVec = _mm512_maskz_set1_epi16(-1u, remainder);
             return (_cvtmask32_u32(_mm512_mask_cmpeq_epu16_mask(-1u, packedStore, remainderVec)) >> WordOffset) & mask;
         }
 
         inline std::uint64_t queryVectorized(std::uint_fast16_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            if constexpr (TwoCachelines) {
+                return queryTwoCachelines(remainder) & ((1ull << bounds.second) - (1ull << bounds.first));
+            }
             __mmask32 queryMask = _cvtu32_mask32(((1u << bounds.second) - (1u << bounds.first)) << WordOffset);
             __m512i packedStore = loadRemainders();
             __m512i remainderVec = _mm512_maskz_set1_epi16(-1, remainder);
@@ -664,23 +783,99 @@ namespace PQF {
         }
     };
 
-    template<std::size_t NumRemainders, std::size_t Offset>
-    struct alignas(1) RemainderStore<20, NumRemainders, Offset> : RemainderStoreTwoPieces<16, 4, NumRemainders, Offset>{};
-
     
 
 
-    #else
+    #elif !PQF_SCALAR
 
     // AVX2 implementations
 
+    //AVX2 has no full width byte permute, so inserts and deletes treat a bucket as two 256 bit halves and shift both by whole elements, using permute2x128 to carry bytes across the lanes (and from the low half into the high half).
+    //Begin and End are the byte range of the store relative to the start of the bucket; halves the store does not touch are never loaded or stored, so 32 byte buckets only ever touch their own 32 bytes.
+    template<std::size_t ElementBytes, std::size_t Begin, std::size_t End>
+    struct AVX2BucketShifter {
+        static_assert(End <= 64 && Begin < End);
+        inline static constexpr bool UseLow = Begin < 32;
+        inline static constexpr bool UseHigh = End > 32;
+
+        inline static constexpr __m256i byteIndices(std::size_t start) {
+            std::array<char, 32> bytes;
+            for(size_t i=0; i < 32; i++) {
+                bytes[i] = start+i;
+            }
+            return std::bit_cast<__m256i>(bytes);
+        }
+
+        inline static constexpr __m256i LowIndices = byteIndices(0);
+        inline static constexpr __m256i HighIndices = byteIndices(32);
+
+        //Moves everything up by Bytes (towards higher addresses), shifting in zeros at the bottom of the bucket
+        template<std::size_t Bytes = ElementBytes>
+        inline static void shiftUp(__m256i& low, __m256i& high) {
+            high = _mm256_alignr_epi8(high, _mm256_permute2x128_si256(low, high, 0x21), 16-Bytes);
+            low = _mm256_alignr_epi8(low, _mm256_permute2x128_si256(low, low, 0x08), 16-Bytes);
+        }
+
+        //Moves everything down by Bytes, shifting in zeros at the top of the bucket
+        template<std::size_t Bytes = ElementBytes>
+        inline static void shiftDown(__m256i& low, __m256i& high) {
+            low = _mm256_alignr_epi8(_mm256_permute2x128_si256(low, high, 0x21), low, Bytes);
+            high = _mm256_alignr_epi8(_mm256_permute2x128_si256(high, high, 0x81), high, Bytes);
+        }
+
+        //Mask of the bytes in [begin, end)
+        inline static __m256i rangeMask(__m256i indices, std::size_t begin, std::size_t end) {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(indices, _mm256_set1_epi8(begin-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(end), indices));
+        }
+
+        inline static void load(const void* bucket, __m256i& low, __m256i& high) {
+            low = UseLow ? _mm256_load_si256(reinterpret_cast<const __m256i*>(bucket)) : _mm256_setzero_si256();
+            high = UseHigh ? _mm256_load_si256(reinterpret_cast<const __m256i*>(bucket) + 1) : _mm256_setzero_si256();
+        }
+
+        inline static void store(void* bucket, __m256i low, __m256i high) {
+            if constexpr (UseLow) _mm256_store_si256(reinterpret_cast<__m256i*>(bucket), low);
+            if constexpr (UseHigh) _mm256_store_si256(reinterpret_cast<__m256i*>(bucket) + 1, high);
+        }
+
+        //Opens a slot at byte pos and writes value (broadcast to every element) there. Whatever was in the last slot falls off the end.
+        inline static void insert(void* bucket, std::size_t pos, __m256i value) {
+            __m256i low, high;
+            load(bucket, low, high);
+            __m256i shiftedLow = low, shiftedHigh = high;
+            shiftUp(shiftedLow, shiftedHigh);
+            if constexpr (UseLow) {
+                low = _mm256_blendv_epi8(low, shiftedLow, rangeMask(LowIndices, pos+ElementBytes, End));
+                low = _mm256_blendv_epi8(low, value, rangeMask(LowIndices, pos, pos+ElementBytes));
+            }
+            if constexpr (UseHigh) {
+                high = _mm256_blendv_epi8(high, shiftedHigh, rangeMask(HighIndices, pos+ElementBytes, End));
+                high = _mm256_blendv_epi8(high, value, rangeMask(HighIndices, pos, pos+ElementBytes));
+            }
+            store(bucket, low, high);
+        }
+
+        //Closes the slot at byte pos. The last slot keeps its old value, same as a memmove would.
+        inline static void remove(void* bucket, std::size_t pos) {
+            __m256i low, high;
+            load(bucket, low, high);
+            __m256i shiftedLow = low, shiftedHigh = high;
+            shiftDown(shiftedLow, shiftedHigh);
+            if constexpr (UseLow) low = _mm256_blendv_epi8(low, shiftedLow, rangeMask(LowIndices, pos, End-ElementBytes));
+            if constexpr (UseHigh) high = _mm256_blendv_epi8(high, shiftedHigh, rangeMask(HighIndices, pos, End-ElementBytes));
+            store(bucket, low, high);
+        }
+    };
+
     template<std::size_t NumRemainders, std::size_t Offset>
     struct alignas(1) RemainderStore<8, NumRemainders, Offset> {
-        inline static constexpr bool CanSplit = false;
+        inline static constexpr bool CanSplit = true;
 
         inline static constexpr std::size_t Size = NumRemainders;
         std::array<std::uint8_t, NumRemainders> remainders;
 
+        using Shifter = AVX2BucketShifter<1, Offset, Offset+Size>;
+
         inline __m256i* getNonOffsetBucketAddress2() {
             return reinterpret_cast<__m256i*>(reinterpret_cast<std::uint8_t*>(&remainders[0]) - Offset);
         }
@@ -690,19 +885,14 @@ namespace PQF {
         }
 
         inline std::uint_fast8_t insert(std::uint_fast8_t remainder, std::size_t loc) {
-            // std::cout << "inserting " << ((std::size_t)remainder) << " " << loc << std::endl;
             if (loc >= NumRemainders) return remainder;
             std::uint_fast8_t retval = remainders[NumRemainders-1];
-            
-            std::memmove((&remainders[loc])+1, &remainders[loc], NumRemainders - loc - 1);
-            remainders[loc] = remainder;
-
+            Shifter::insert(getNonOffsetBucketAddress2(), loc+Offset, _mm256_set1_epi8(remainder));
             return retval;
         }
 
         inline void remove(std::size_t loc) {
-            // std::cout << "removing " << loc << std::endl;
-            std::memmove(&remainders[loc], (&remainders[loc]) + 1, NumRemainders - loc - 1);
+            Shifter::remove(getNonOffsetBucketAddress2(), loc+Offset);
         }
 
         //Removes and returns the value that was there
@@ -730,24 +920,31 @@ namespace PQF {
 
         inline std::uint64_t queryVectorizedMask(std::uint_fast8_t remainder, std::uint64_t mask) {
             __m256i remainderVec = _mm256_set1_epi8(remainder);
-            __m256i packedStore1 = _mm256_loadu_si256(getNonOffsetBucketAddress2());
-            __m256i cmp1 = _mm256_cmpeq_epi8(remainderVec, packedStore1);
-            // lolol ridiculous cast but otherwise adds 1s when casting negative number which is rather undesirable.
-            std::uint64_t result1 = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1))) >> Offset;
-
-            if constexpr (Offset + NumRemainders <= 32) {
-                return result1 & mask;
+            if constexpr (Offset >= 32) { //Only in the high half, like the 8 bit piece of a 24 bit store
+                __m256i packedStore = _mm256_load_si256(getNonOffsetBucketAddress2() + 1);
+                std::uint64_t result = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(remainderVec, packedStore)))) >> (Offset - 32);
+                return result & mask;
             }
+            else {
+                __m256i packedStore1 = _mm256_loadu_si256(getNonOffsetBucketAddress2());
+                __m256i cmp1 = _mm256_cmpeq_epi8(remainderVec, packedStore1);
+                // lolol ridiculous cast but otherwise adds 1s when casting negative number which is rather undesirable.
+                std::uint64_t result1 = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1))) >> Offset;
+
+                if constexpr (Offset + NumRemainders <= 32) {
+                    return result1 & mask;
+                }
 
-            __m256i packedStore2 = _mm256_loadu_si256(getNonOffsetBucketAddress2() + 1);
-            __m256i cmp2 = _mm256_cmpeq_epi8(remainderVec, packedStore2);
-            // Assuming offset < 32 here! Which should be true since otherwise would cross cacheline boundary if more than 32 bytes
-            assert (Offset < 32);
-            std::uint64_t result2 = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp2))) << (32 - Offset);
+                __m256i packedStore2 = _mm256_loadu_si256(getNonOffsetBucketAddress2() + 1);
+                __m256i cmp2 = _mm256_cmpeq_epi8(remainderVec, packedStore2);
+                // Assuming offset < 32 here! Which should be true since otherwise would cross cacheline boundary if more than 32 bytes
+                assert (Offset < 32);
+                std::uint64_t result2 = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp2))) << (32 - Offset);
 
-            // std::cout << result1 << " " << result2 << std::endl;
+                // std::cout << result1 << " " << result2 << std::endl;
 
-            return (result1 | result2) & mask;
+                return (result1 | result2) & mask;
+            }
         }
 
         inline std::uint64_t queryVectorized(std::uint_fast8_t remainder, std::pair<std::size_t, std::size_t> bounds) {
@@ -761,6 +958,28 @@ namespace PQF {
             }
             return queryVectorized(remainder, bounds);
         }
+
+        //Same as the AVX512 version except it leaves the mini filters alone: a gets the remainders selected by mask, b the rest, both packed to the front of the store.
+        //No byte compress in AVX2, so compress eight remainders at a time with pext.
+        inline void split(RemainderStore& a, RemainderStore& b, uint64_t mask) const {
+            std::array<std::uint8_t, NumRemainders + 8> aPacked, bPacked;
+            std::size_t aCount = 0, bCount = 0;
+            for(size_t i=0; i < NumRemainders; i+=8) {
+                std::uint64_t word = 0;
+                std::memcpy(&word, &remainders[i], std::min<std::size_t>(8, NumRemainders-i));
+                std::uint64_t validBytes = NumRemainders - i >= 8 ? 0xFF : (1ull << (NumRemainders-i)) - 1;
+                std::uint64_t aBytes = (mask >> i) & validBytes;
+                std::uint64_t bBytes = (~mask >> i) & validBytes;
+                std::uint64_t aWord = _pext_u64(word, _pdep_u64(aBytes, 0x0101010101010101ull) * 0xFF);
+                std::uint64_t bWord = _pext_u64(word, _pdep_u64(bBytes, 0x0101010101010101ull) * 0xFF);
+                std::memcpy(&aPacked[aCount], &aWord, 8);
+                std::memcpy(&bPacked[bCount], &bWord, 8);
+                aCount += __builtin_popcountll(aBytes);
+                bCount += __builtin_popcountll(bBytes);
+            }
+            std::memcpy(&a.remainders[0], &aPacked[0], aCount);
+            std::memcpy(&b.remainders[0], &bPacked[0], bCount);
+        }
     };
 
 
@@ -768,15 +987,15 @@ namespace PQF {
 
     template<std::size_t NumRemainders, std::size_t Offset>
     struct alignas(1) RemainderStore<4, NumRemainders, Offset> {
-        static constexpr std::size_t OffsetHalf = (Offset >= 32) ? Offset - 32 : Offset;
         inline static constexpr bool CanSplit = false;
 
         inline static constexpr std::size_t Size = (NumRemainders+1)/2;
-        static_assert((Size + Offset-1) / 32 - (Offset / 32) == 0, "AVX2 4 bit store only implemented for something fitting neatly into 256 bits.");
         std::array<std::uint8_t, Size> remainders;
 
+        using Shifter = AVX2BucketShifter<1, Offset, Offset+Size>;
+
         inline __m256i* getNonOffsetBucketAddress2() {
-            return reinterpret_cast<__m256i*>(reinterpret_cast<std::uint8_t*>(&remainders[0]) - OffsetHalf);
+            return reinterpret_cast<__m256i*>(reinterpret_cast<std::uint8_t*>(&remainders[0]) - Offset);
         }
 
         inline static void set4Bits(std::uint_fast8_t& byte, std::uint_fast8_t bitGroup, std::uint_fast8_t bits) {
@@ -794,44 +1013,88 @@ namespace PQF {
             return get4Bits(remainders[loc/2], loc % 2);
         }
 
-        //Just do it direclty with 64 bit numbers rather than avx2, honestly probably not worse (maybe worse but whatever)
+        inline static constexpr __m256i laneBitIndices(std::size_t start) {
+            std::array<int, 8> lanes;
+            for(size_t i=0; i < 8; i++) {
+                lanes[i] = (start + i)*32;
+            }
+            return std::bit_cast<__m256i>(lanes);
+        }
+
+        inline static constexpr __m256i LowLaneBits = laneBitIndices(0);
+        inline static constexpr __m256i HighLaneBits = laneBitIndices(8);
+
+        //Mask of all the bits at or above bit pos of the bucket, built per 32 bit lane since AVX2 only has variable shifts within lanes (and those conveniently give zero for shifts of 32 or more)
+        inline static __m256i bitsFromMask(__m256i laneBits, std::size_t pos) {
+            __m256i shift = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(pos), laneBits), _mm256_setzero_si256()), _mm256_set1_epi32(32));
+            return _mm256_sllv_epi32(_mm256_set1_epi32(-1), shift);
+        }
+
+        inline static constexpr __m256i storeMask(std::size_t start, std::size_t endBit) {
+            std::array<std::uint8_t, 32> bytes;
+            for(size_t i=0; i < 32; i++) {
+                std::size_t bit = (start+i)*8;
+                bytes[i] = bit+8 <= endBit ? 0xFF : (bit >= endBit ? 0 : (1u << (endBit-bit)) - 1);
+            }
+            return std::bit_cast<__m256i>(bytes);
+        }
+
+        //Insert shifts every nibble of the store, remove leaves the last one alone
+        inline static constexpr __m256i InsertLowMask = storeMask(0, (Offset+Size)*8);
+        inline static constexpr __m256i InsertHighMask = storeMask(32, (Offset+Size)*8);
+        inline static constexpr __m256i RemoveLowMask = storeMask(0, (Offset+Size)*8-4);
+        inline static constexpr __m256i RemoveHighMask = storeMask(32, (Offset+Size)*8-4);
+
+        //Moves the nibbles in [pos, end) to shifted, where shifted is the bucket moved by one nibble. Same blend for insert and remove.
+        inline static __m256i blendNibbles(__m256i original, __m256i shifted, __m256i fromMask, __m256i endMask) {
+            __m256i takeShifted = _mm256_and_si256(fromMask, endMask);
+            return _mm256_or_si256(_mm256_andnot_si256(takeShifted, original), _mm256_and_si256(takeShifted, shifted));
+        }
+
         inline std::uint_fast8_t insert(std::uint_fast8_t remainder, std::size_t loc) {
             if (loc >= NumRemainders) {
                 return remainder;
             }
             std::uint_fast8_t retval = get(NumRemainders-1);
 
-            std::uint64_t temp[4];
-            // WOW &remainders != &remainders[0]!!!! That is crazy! (it was overwriting past the end)
-            std::memcpy(temp, (&remainders[0]) + (loc/2), Size - (loc/2));
-            std::uint64_t first4 = temp[0] & 0b1111;
-            temp[3] = (temp[2] >> 60) | (temp[3] << 4ull);
-            temp[2] = (temp[1] >> 60) | (temp[2] << 4ull);
-            temp[1] = (temp[0] >> 60) | (temp[1] << 4ull);
-            std::uint64_t bitGroup = (loc % 2) * 4;
-            std::uint64_t first_byte = (first4 << (4 - bitGroup)) + (remainder << bitGroup);
-            temp[0] = ((temp[0] & (~0b1111)) << 4ull) | first_byte;
-
-            // std::cout << "jj " << ((uint64_t)remainders[Size]) << std::endl;
-            std::memcpy((&remainders[0]) + (loc/2), temp, Size - (loc/2));
-            // std::cout << "jjk " << ((uint64_t)remainders[Size]) << std::endl;
+            std::size_t pos = Offset*8 + loc*4;
+            __m256i low, high;
+            Shifter::load(getNonOffsetBucketAddress2(), low, high);
+            //Shift each qword up by a nibble, carrying in the top nibble of the qword below it
+            __m256i belowLow = low, belowHigh = high;
+            Shifter::template shiftUp<8>(belowLow, belowHigh);
+            __m256i shiftedLow = _mm256_or_si256(_mm256_slli_epi64(low, 4), _mm256_srli_epi64(belowLow, 60));
+            __m256i shiftedHigh = _mm256_or_si256(_mm256_slli_epi64(high, 4), _mm256_srli_epi64(belowHigh, 60));
+            //The new remainder goes in the nibble at pos, which the shift filled with the nibble below pos, so overwrite it
+            __m256i remainderVec = _mm256_set1_epi8(remainder * 0x11);
+            if constexpr (Shifter::UseLow) {
+                __m256i fromPos = bitsFromMask(LowLaneBits, pos);
+                __m256i atPos = _mm256_andnot_si256(bitsFromMask(LowLaneBits, pos+4), fromPos);
+                shiftedLow = _mm256_or_si256(_mm256_andnot_si256(atPos, shiftedLow), _mm256_and_si256(atPos, remainderVec));
+                low = blendNibbles(low, shiftedLow, fromPos, InsertLowMask);
+            }
+            if constexpr (Shifter::UseHigh) {
+                __m256i fromPos = bitsFromMask(HighLaneBits, pos);
+                __m256i atPos = _mm256_andnot_si256(bitsFromMask(HighLaneBits, pos+4), fromPos);
+                shiftedHigh = _mm256_or_si256(_mm256_andnot_si256(atPos, shiftedHigh), _mm256_and_si256(atPos, remainderVec));
+                high = blendNibbles(high, shiftedHigh, fromPos, InsertHighMask);
+            }
+            Shifter::store(getNonOffsetBucketAddress2(), low, high);
 
             return retval;
         }
 
         inline void remove(std::size_t loc) {
-            std::uint64_t temp[4];
-            std::memcpy(temp, (&remainders[0]) + loc/2, Size - loc/2);
-            std::uint64_t first4 = temp[0] & 0b1111;
-            temp[0] = (temp[0] >> 4ull) | (temp[1] << 60ull);
-            temp[1] = (temp[1] >> 4ull) | (temp[2] << 60ull);
-            temp[2] = (temp[2] >> 4ull) | (temp[3] << 60ull);
-            temp[3] = temp[3] >> 4ull;
-            //means deleting middle 4 of the first byte, not the first 4, so gotta bring first 4 back
-            if (loc % 2 == 1) 
-                temp[0] = (temp[0] & (~0b1111)) | first4;
-
-            std::memcpy((&remainders[0]) + loc/2, temp, Size - loc/2);
+            std::size_t pos = Offset*8 + loc*4;
+            __m256i low, high;
+            Shifter::load(getNonOffsetBucketAddress2(), low, high);
+            __m256i aboveLow = low, aboveHigh = high;
+            Shifter::template shiftDown<8>(aboveLow, aboveHigh);
+            __m256i shiftedLow = _mm256_or_si256(_mm256_srli_epi64(low, 4), _mm256_slli_epi64(aboveLow, 60));
+            __m256i shiftedHigh = _mm256_or_si256(_mm256_srli_epi64(high, 4), _mm256_slli_epi64(aboveHigh, 60));
+            if constexpr (Shifter::UseLow) low = blendNibbles(low, shiftedLow, bitsFromMask(LowLaneBits, pos), RemoveLowMask);
+            if constexpr (Shifter::UseHigh) high = blendNibbles(high, shiftedHigh, bitsFromMask(HighLaneBits, pos), RemoveHighMask);
+            Shifter::store(getNonOffsetBucketAddress2(), low, high);
         }
 
         //Removes and returns the value that was there
@@ -868,7 +1131,6 @@ namespace PQF {
 
 
         inline std::uint64_t queryVectorizedMask(std::uint_fast8_t remainder, std::uint64_t mask) {
-            //since we're assuming it fits in 32 bytes shouldn't be too bad.
 
             constexpr __m256i bottommask = {0x0F0F0F0F0F0F0F0Full, 0x0F0F0F0F0F0F0F0Full, 0x0F0F0F0F0F0F0F0Full, 0x0F0F0F0F0F0F0F0Full};
             //Why did intel choose to do this as a signed integer wth
@@ -877,14 +1139,23 @@ namespace PQF {
 
             __m256i remainderVec_low = _mm256_set1_epi8(remainder);
             __m256i remainderVec_high = _mm256_set1_epi8(remainder << 4);
-            __m256i packedStore = _mm256_loadu_si256(getNonOffsetBucketAddress2());
-            __m256i packedStore_low = _mm256_and_si256(packedStore, bottommask);
-            __m256i packedStore_high = _mm256_and_si256(packedStore, topmask);
-            __m256i cmp_low = _mm256_cmpeq_epi8(packedStore_low, remainderVec_low);
-            __m256i cmp_high = _mm256_cmpeq_epi8(packedStore_high, remainderVec_high);
-            std::uint64_t result_low = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_low)));
-            std::uint64_t result_high = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_high)));
-            std::uint64_t result = interleave_bits(result_low >> OffsetHalf, result_high >> OffsetHalf);
+            std::uint64_t result_low = 0;
+            std::uint64_t result_high = 0;
+            if constexpr (Shifter::UseLow) {
+                __m256i packedStore = _mm256_load_si256(getNonOffsetBucketAddress2());
+                __m256i cmp_low = _mm256_cmpeq_epi8(_mm256_and_si256(packedStore, bottommask), remainderVec_low);
+                __m256i cmp_high = _mm256_cmpeq_epi8(_mm256_and_si256(packedStore, topmask), remainderVec_high);
+                result_low = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_low)));
+                result_high = static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_high)));
+            }
+            if constexpr (Shifter::UseHigh) {
+                __m256i packedStore = _mm256_load_si256(getNonOffsetBucketAddress2() + 1);
+                __m256i cmp_low = _mm256_cmpeq_epi8(_mm256_and_si256(packedStore, bottommask), remainderVec_low);
+                __m256i cmp_high = _mm256_cmpeq_epi8(_mm256_and_si256(packedStore, topmask), remainderVec_high);
+                result_low |= static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_low))) << 32;
+                result_high |= static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp_high))) << 32;
+            }
+            std::uint64_t result = interleave_bits(result_low >> Offset, result_high >> Offset);
 
             // std::cout << result << std::endl;
 
@@ -904,9 +1175,6 @@ namespace PQF {
         }
     };
 
-    template<std::size_t NumRemainders, std::size_t Offset>
-    struct alignas(1) RemainderStore<12, NumRemainders, Offset> : RemainderStoreTwoPieces<8, 4, NumRemainders, Offset>{};
-
     template<std::size_t NumRemainders, std::size_t Offset>
     struct alignas(1) RemainderStore<16, NumRemainders, Offset> {
         inline static constexpr bool CanSplit = false;
@@ -918,6 +1186,13 @@ namespace PQF {
 
         inline static constexpr size_t WordOffset = Offset/2;
 
+        //128 byte buckets: the store runs past the first cacheline, so each cacheline gets its own shifter and an element is carried between them
+        inline static constexpr bool TwoCachelines = Offset + Size > 64;
+        static_assert(Offset + Size <= 128);
+
+        using Shifter = AVX2BucketShifter<2, Offset, TwoCachelines ? 64 : Offset+Size>;
+        using HighShifter = AVX2BucketShifter<2, 0, TwoCachelines ? Offset+Size-64 : 2>;
+
         inline __m256i* getNonOffsetBucketAddress2() {
             return reinterpret_cast<__m256i*>(reinterpret_cast<std::uint16_t*>(&remainders[0]) - WordOffset);
         }
@@ -927,19 +1202,41 @@ namespace PQF {
         }
 
         inline std::uint_fast16_t insert(std::uint_fast16_t remainder, std::size_t loc) {
-            // std::cout << "inserting " << ((std::size_t)remainder) << " " << loc << " " << remainders[0] << std::endl;
             if (loc >= NumRemainders) return remainder;
             std::uint_fast16_t retval = remainders[NumRemainders-1];
-            
-            std::memmove((&remainders[loc])+1, &remainders[loc], (NumRemainders - loc - 1)*2);
-            remainders[loc] = remainder;
-
+            std::size_t pos = loc*2+Offset;
+            if constexpr (TwoCachelines) {
+                __m256i* bucket = getNonOffsetBucketAddress2();
+                if(pos < 64) {
+                    std::uint_fast16_t carried = reinterpret_cast<std::uint16_t*>(bucket)[31];
+                    Shifter::insert(bucket, pos, _mm256_set1_epi16(remainder));
+                    HighShifter::insert(bucket + 2, 0, _mm256_set1_epi16(carried));
+                }
+                else {
+                    HighShifter::insert(bucket + 2, pos - 64, _mm256_set1_epi16(remainder));
+                }
+                return retval;
+            }
+            Shifter::insert(getNonOffsetBucketAddress2(), pos, _mm256_set1_epi16(remainder));
             return retval;
         }
 
         inline void remove(std::size_t loc) {
-            // std::cout << "removing " << loc << std::endl;
-            std::memmove(&remainders[loc], (&remainders[loc]) + 1, (NumRemainders - loc - 1)*2);
+            std::size_t pos = loc*2+Offset;
+            if constexpr (TwoCachelines) {
+                __m256i* bucket = getNonOffsetBucketAddress2();
+                if(pos < 64) {
+                    std::uint16_t carried = reinterpret_cast<std::uint16_t*>(bucket)[32];
+                    Shifter::remove(bucket, pos);
+                    reinterpret_cast<std::uint16_t*>(bucket)[31] = carried;
+                    HighShifter::remove(bucket + 2, 0);
+                }
+                else {
+                    HighShifter::remove(bucket + 2, pos - 64);
+                }
+                return;
+            }
+            Shifter::remove(getNonOffsetBucketAddress2(), pos);
         }
 
         //Removes and returns the value that was there
@@ -968,25 +1265,40 @@ namespace PQF {
         inline std::uint64_t queryVectorizedMask(std::uint_fast16_t remainder, std::uint64_t mask) {
             // std::cout << remainders[12] << " " << remainder << " " << WordOffset << std::endl;
             __m256i remainderVec = _mm256_set1_epi16(remainder);
-            __m256i packedStore1 = _mm256_loadu_si256(getNonOffsetBucketAddress2());
-            __m256i cmp1 = _mm256_cmpeq_epi16(remainderVec, packedStore1);
+            if constexpr (TwoCachelines) {
+                std::uint64_t result = 0;
+                for(std::size_t i = Offset/32; i*32 < Offset + Size; i++) {
+                    __m256i packedStore = _mm256_load_si256(getNonOffsetBucketAddress2() + i);
+                    result |= static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(remainderVec, packedStore))), 0x55555555u)) << (16*i);
+                }
+                return (result >> WordOffset) & mask;
+            }
+            else if constexpr (Offset >= 32) { //Only in the high half, like the second piece of a 32 bit store
+                __m256i packedStore = _mm256_load_si256(getNonOffsetBucketAddress2() + 1);
+                std::uint64_t result = static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(remainderVec, packedStore))), 0x55555555u)) >> (WordOffset - 16);
+                return result & mask;
+            }
+            else {
+                __m256i packedStore1 = _mm256_loadu_si256(getNonOffsetBucketAddress2());
+                __m256i cmp1 = _mm256_cmpeq_epi16(remainderVec, packedStore1);
             
-            // std::cout << std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1)) << std::endl;
-            std::uint64_t result1 = static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1)), 0x55555555u)) >> WordOffset;
+                // std::cout << std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1)) << std::endl;
+                std::uint64_t result1 = static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp1)), 0x55555555u)) >> WordOffset;
 
-            if constexpr (WordOffset + NumRemainders <= 16) {
-                return result1 & mask;
-            }
+                if constexpr (WordOffset + NumRemainders <= 16) {
+                    return result1 & mask;
+                }
 
-            __m256i packedStore2 = _mm256_loadu_si256(getNonOffsetBucketAddress2() + 1);
-            __m256i cmp2 = _mm256_cmpeq_epi16(remainderVec, packedStore2);
-            // Assuming offset < 32 here! Which should be true since otherwise would cross cacheline boundary if more than 32 bytes
-            assert (Offset < 32);
-            std::uint64_t result2 = static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp2)), 0x55555555u)) << (16 - WordOffset);
+                __m256i packedStore2 = _mm256_loadu_si256(getNonOffsetBucketAddress2() + 1);
+                __m256i cmp2 = _mm256_cmpeq_epi16(remainderVec, packedStore2);
+                // Assuming offset < 32 here! Which should be true since otherwise would cross cacheline boundary if more than 32 bytes
+                assert (Offset < 32);
+                std::uint64_t result2 = static_cast<std::uint64_t>(_pext_u32(std::bit_cast<std::uint32_t>(_mm256_movemask_epi8(cmp2)), 0x55555555u)) << (16 - WordOffset);
 
-            // std::cout << result1 << " " << result2 << " " << (*((uint16_t*)(&packedStore2))) << std::endl;
+                // std::cout << result1 << " " << result2 << " " << (*((uint16_t*)(&packedStore2))) << std::endl;
 
-            return (result1 | result2) & mask;
+                return (result1 | result2) & mask;
+            }
         }
 
         inline std::uint64_t queryVectorized(std::uint_fast16_t remainder, std::pair<std::size_t, std::size_t> bounds) {
@@ -1002,10 +1314,591 @@ namespace PQF {
         }
     };
 
+    #else
+
+    // Scalar implementations
+
+    //No intrinsics here: the store is read a 64 bit word at a time and every Width bit lane is compared at once (SWAR), and inserts and removes are a memmove (or a shift across words for 4 bit remainders).
+    //Unlike the vector versions these only touch the bytes of the store itself, so they make no assumptions about where in the bucket the store is.
+    template<std::size_t Width>
+    struct ScalarLanes {
+        static_assert(Width == 4 || Width == 8 || Width == 16);
+
+        inline static constexpr std::uint64_t LowBits = Width == 4 ? 0x1111111111111111ull : (Width == 8 ? 0x0101010101010101ull : 0x0001000100010001ull);
+        inline static constexpr std::uint64_t HighBits = LowBits << (Width-1);
+        inline static constexpr std::size_t LanesPerWord = 64/Width;
+
+        //High bit of every lane of word equal to the matching lane of the broadcasted value. Exact, unlike the usual haszero trick, since the low bits are added without carrying out of the lane.
+        inline static std::uint64_t matchingLanes(std::uint64_t word, std::uint64_t broadcastValue) {
+            std::uint64_t diff = word ^ broadcastValue;
+            return ~(((diff & ~HighBits) + ~HighBits) | diff) & HighBits;
+        }
+
+        //Packs the high bit of every lane into the low LanesPerWord bits. With 8 and 16 bit lanes a multiply moves every bit to its place with no two partial products landing on the same bit; 4 bit lanes are too close together for that, so they get folded in halves.
+        inline static std::uint64_t packHighBits(std::uint64_t lanes) {
+            std::uint64_t bits = lanes >> (Width-1);
+            if constexpr (Width == 8) {
+                return (bits * 0x0102040810204080ull) >> 56;
+            }
+            else if constexpr (Width == 16) {
+                return ((bits * 0x0000200040008001ull) >> 45) & 0xF;
+            }
+            else {
+                bits = (bits | (bits >> 3)) & 0x0303030303030303ull;
+                bits = (bits | (bits >> 6)) & 0x000F000F000F000Full;
+                bits = (bits | (bits >> 12)) & 0x000000FF000000FFull;
+                return (bits | (bits >> 24)) & 0xFFFF;
+            }
+        }
+
+        //Bit i set iff remainder i of the store equals value, for the remainders in [first, last). Only loads the words those fall in, which is usually just one, since a mini bucket rarely holds more than a couple of keys.
+        template<std::size_t Bytes>
+        inline static std::uint64_t query(const std::uint8_t* store, std::uint64_t value, std::size_t first, std::size_t last) {
+            std::uint64_t broadcastValue = value * LowBits;
+            std::uint64_t result = 0;
+            for(std::size_t i = first/LanesPerWord; i*LanesPerWord < last; i++) {
+                std::uint64_t word = 0;
+                if(i*8 + 8 <= Bytes) {
+                    std::memcpy(&word, store + i*8, 8);
+                }
+                else {
+                    std::memcpy(&word, store + i*8, Bytes % 8);
+                }
+                result |= packHighBits(matchingLanes(word, broadcastValue)) << (i*LanesPerWord);
+            }
+            std::uint64_t lastMask = last < 64 ? (1ull << last) - 1 : -1ull;
+            return result & lastMask & (-1ull << first);
+        }
+
+        //Same, but for the remainders set in mask
+        template<std::size_t Bytes>
+        inline static std::uint64_t queryMask(const std::uint8_t* store, std::uint64_t value, std::uint64_t mask) {
+            if(mask == 0) return 0;
+            return query<Bytes>(store, value, std::countr_zero(mask), 64 - std::countl_zero(mask)) & mask;
+        }
+    };
+
     template<std::size_t NumRemainders, std::size_t Offset>
-    struct alignas(1) RemainderStore<20, NumRemainders, Offset> : RemainderStoreTwoPieces<16, 4, NumRemainders, Offset>{};
+    struct alignas(1) RemainderStore<8, NumRemainders, Offset> {
+        inline static constexpr bool CanSplit = true;
+
+        inline static constexpr std::size_t Size = NumRemainders;
+        std::array<std::uint8_t, NumRemainders> remainders;
+
+        inline std::uint64_t get(std::size_t loc) const {
+            return remainders[loc];
+        }
+
+        inline std::uint_fast8_t insert(std::uint_fast8_t remainder, std::size_t loc) {
+            if (loc >= NumRemainders) return remainder;
+            std::uint_fast8_t retval = remainders[NumRemainders-1];
+            std::memmove(&remainders[loc+1], &remainders[loc], NumRemainders-1-loc);
+            remainders[loc] = remainder;
+            return retval;
+        }
+
+        inline void remove(std::size_t loc) {
+            std::memmove(&remainders[loc], &remainders[loc+1], NumRemainders-1-loc);
+        }
+
+        //Removes and returns the value that was there
+        inline std::uint_fast8_t removeReturn(std::size_t loc) {
+            std::uint_fast8_t retval = remainders[loc];
+            remove(loc);
+            return retval;
+        }
+
+        inline std::uint_fast8_t removeFirst() {
+            std::uint_fast8_t first = remainders[0];
+            remove(0);
+            return first;
+        }
+
+        inline std::uint64_t queryNonVectorized(std::uint_fast8_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            std::uint64_t retMask = 0;
+            for(size_t i{bounds.first}; i < bounds.second; i++) {
+                if(remainders[i] == remainder) {
+                    retMask |= 1ull << i;
+                }
+            }
+            return retMask;
+        }
+
+        inline std::uint64_t queryVectorizedMask(std::uint_fast8_t remainder, std::uint64_t mask) {
+            return ScalarLanes<8>::queryMask<Size>(&remainders[0], remainder, mask);
+        }
+
+        inline std::uint64_t queryVectorized(std::uint_fast8_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            return ScalarLanes<8>::query<Size>(&remainders[0], remainder, bounds.first, bounds.second);
+        }
+
+        // Returns a bitmask of which remainders match within the bounds. Maybe this should return not a uint64_t but a mask type? Cause we should be able to do everything with them
+        inline std::uint64_t query(std::uint_fast8_t remainder, std::pair<size_t, size_t> bounds) {
+            if constexpr (DEBUG) {
+                assert(bounds.second <= NumRemainders);
+            }
+            return queryVectorized(remainder, bounds);
+        }
+
+        //a gets the remainders selected by mask, b the rest, both packed to the front of the store
+        inline void split(RemainderStore& a, RemainderStore& b, uint64_t mask) const {
+            std::size_t aCount = 0, bCount = 0;
+            for(size_t i=0; i < NumRemainders; i++) {
+                if((mask >> i) & 1) {
+                    a.remainders[aCount++] = remainders[i];
+                }
+                else {
+                    b.remainders[bCount++] = remainders[i];
+                }
+            }
+        }
+    };
+
+
+    // 4 BIT
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<4, NumRemainders, Offset> {
+        inline static constexpr bool CanSplit = false;
+
+        inline static constexpr std::size_t Size = (NumRemainders+1)/2;
+        std::array<std::uint8_t, Size> remainders;
+
+        inline static constexpr std::size_t NumWords = (Size+7)/8;
+
+        inline static void set4Bits(std::uint_fast8_t& byte, std::uint_fast8_t bitGroup, std::uint_fast8_t bits) {
+            if constexpr (DEBUG) assert(bitGroup <= 1 && bits < 16);
+            byte = (byte & (0b1111 << ((1-bitGroup)*4))) + (bits << (bitGroup*4));
+        }
+
+        //bitGroup = 0 if lower order, 1 if higher order
+        inline static std::uint_fast8_t get4Bits(std::uint_fast8_t byte, std::uint_fast8_t bitGroup) {
+            if constexpr (DEBUG) assert(bitGroup <= 1 && (byte & (0b1111 << (bitGroup*4))) >> (bitGroup*4) <16);
+            return (byte & (0b1111 << (bitGroup*4))) >> (bitGroup*4);
+        }
+
+        inline std::uint64_t get(std::size_t loc) const {
+            return get4Bits(remainders[loc/2], loc % 2);
+        }
+
+        inline std::array<std::uint64_t, NumWords> loadWords() const {
+            std::array<std::uint64_t, NumWords> words{};
+            std::memcpy(&words[0], &remainders[0], Size);
+            return words;
+        }
+
+        inline void storeWords(const std::array<std::uint64_t, NumWords>& words) {
+            std::memcpy(&remainders[0], &words[0], Size);
+        }
+
+        //Bits of word i at or above bit pos of the store
+        inline static std::uint64_t bitsFrom(std::size_t i, std::size_t pos) {
+            if(pos <= i*64) return -1ull;
+            if(pos >= (i+1)*64) return 0;
+            return -1ull << (pos - i*64);
+        }
+
+        inline std::uint_fast8_t insert(std::uint_fast8_t remainder, std::size_t loc) {
+            if (loc >= NumRemainders) {
+                return remainder;
+            }
+            std::uint_fast8_t retval = get(NumRemainders-1);
+
+            //Shift every nibble from loc on up by one, carrying the top nibble of each word into the next, then put the remainder at loc
+            std::array<std::uint64_t, NumWords> words = loadWords();
+            std::size_t pos = loc*4;
+            for(std::size_t i=NumWords; i-- > 0;) {
+                std::uint64_t shifted = (words[i] << 4) | (i > 0 ? words[i-1] >> 60 : 0);
+                std::uint64_t fromPos = bitsFrom(i, pos);
+                words[i] = (words[i] & ~fromPos) | (shifted & fromPos);
+            }
+            words[pos/64] = (words[pos/64] & ~(15ull << (pos%64))) | (static_cast<std::uint64_t>(remainder) << (pos%64));
+            storeWords(words);
+
+            return retval;
+        }
+
+        //Leaves the last nibble alone, like the vector versions
+        inline void remove(std::size_t loc) {
+            std::uint_fast8_t last = get(NumRemainders-1);
+            std::array<std::uint64_t, NumWords> words = loadWords();
+            std::size_t pos = loc*4;
+            for(std::size_t i=0; i < NumWords; i++) {
+                std::uint64_t shifted = (words[i] >> 4) | (i+1 < NumWords ? words[i+1] << 60 : 0);
+                std::uint64_t fromPos = bitsFrom(i, pos);
+                words[i] = (words[i] & ~fromPos) | (shifted & fromPos);
+            }
+            storeWords(words);
+            set4Bits(remainders[(NumRemainders-1)/2], (NumRemainders-1)%2, last);
+        }
+
+        //Removes and returns the value that was there
+        inline std::uint_fast8_t removeReturn(std::size_t loc) {
+            std::uint_fast8_t retval = get(loc);
+            remove(loc);
+            return retval;
+        }
+
+        inline std::uint_fast8_t removeFirst() {
+            std::uint_fast8_t first = get(0);
+            remove(0);
+            return first;
+        }
+
+        inline std::uint64_t queryNonVectorized(std::uint_fast8_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            std::uint64_t retMask = 0;
+            for(size_t i{bounds.first}; i < bounds.second; i++) {
+                if(get4Bits(remainders[i/2], i%2) == remainder) {
+                    retMask |= 1ull << i;
+                }
+            }
+            return retMask;
+        }
+
+        inline std::uint64_t queryVectorizedMask(std::uint_fast8_t remainder, std::uint64_t mask) {
+            return ScalarLanes<4>::queryMask<Size>(&remainders[0], remainder, mask);
+        }
+
+        inline std::uint64_t queryVectorized(std::uint_fast8_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            return ScalarLanes<4>::query<Size>(&remainders[0], remainder, bounds.first, bounds.second);
+        }
+
+        // Returns a bitmask of which remainders match within the bounds. Maybe this should return not a uint64_t but a mask type? Cause we should be able to do everything with them
+        inline std::uint64_t query(std::uint_fast8_t remainder, std::pair<size_t, size_t> bounds) {
+            if constexpr (DEBUG) {
+                assert(bounds.second <= NumRemainders);
+            }
+            return queryVectorized(remainder, bounds);
+        }
+    };
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<16, NumRemainders, Offset> {
+        inline static constexpr bool CanSplit = false;
+
+        inline static constexpr std::size_t Size = NumRemainders * 2;
+        std::array<std::uint16_t, NumRemainders> remainders;
+
+        static_assert(Offset % 2 == 0);
+
+        inline std::uint64_t get(std::size_t loc) const {
+            return remainders[loc];
+        }
+
+        inline std::uint_fast16_t insert(std::uint_fast16_t remainder, std::size_t loc) {
+            if (loc >= NumRemainders) return remainder;
+            std::uint_fast16_t retval = remainders[NumRemainders-1];
+            std::memmove(&remainders[loc+1], &remainders[loc], (NumRemainders-1-loc)*2);
+            remainders[loc] = remainder;
+            return retval;
+        }
+
+        inline void remove(std::size_t loc) {
+            std::memmove(&remainders[loc], &remainders[loc+1], (NumRemainders-1-loc)*2);
+        }
+
+        //Removes and returns the value that was there
+        inline std::uint_fast16_t removeReturn(std::size_t loc) {
+            std::uint_fast16_t retval = remainders[loc];
+            remove(loc);
+            return retval;
+        }
+
+        inline std::uint_fast16_t removeFirst() {
+            std::uint_fast16_t first = remainders[0];
+            remove(0);
+            return first;
+        }
+
+        inline std::uint64_t queryNonVectorized(std::uint_fast16_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            std::uint64_t retMask = 0;
+            for(size_t i{bounds.first}; i < bounds.second; i++) {
+                if(remainders[i] == remainder) {
+                    retMask |= 1ull << i;
+                }
+            }
+            return retMask;
+        }
+
+        inline std::uint64_t queryVectorizedMask(std::uint_fast16_t remainder, std::uint64_t mask) {
+            return ScalarLanes<16>::queryMask<Size>(reinterpret_cast<const std::uint8_t*>(&remainders[0]), remainder, mask);
+        }
+
+        inline std::uint64_t queryVectorized(std::uint_fast16_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            return ScalarLanes<16>::query<Size>(reinterpret_cast<const std::uint8_t*>(&remainders[0]), remainder, bounds.first, bounds.second);
+        }
+
+        // Returns a bitmask of which remainders match within the bounds. Maybe this should return not a uint64_t but a mask type? Cause we should be able to do everything with them
+        inline std::uint64_t query(std::uint_fast16_t remainder, std::pair<size_t, size_t> bounds) {
+            if constexpr (DEBUG) {
+                assert(bounds.second <= NumRemainders);
+            }
+            return queryVectorized(remainder, bounds);
+        }
+    };
 
     #endif
+
+    //Remainders of any width up to 16 bits packed back to back, for the widths without a store of their own. Inserts and removes shift the 64 bit words of the bucket the store covers, which works the same on every backend.
+    //Queries put remainder i in 16 bit lane i with a byte permute when there is AVX512 VBMI and no remainder spans more than two bytes (true up to 10 bits, and for 12), and otherwise compare as many remainders at a time as fit in a word with SWAR.
+    template<std::size_t Width, std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStorePacked {
+        static_assert(Width > 0 && Width <= 16);
+        inline static constexpr bool CanSplit = false;
+
+        inline static constexpr std::size_t Size = (Width*NumRemainders + 7)/8;
+        std::array<std::uint8_t, Size> remainders;
+
+        static_assert(Offset + Size <= 64);
+
+        inline static constexpr std::uint64_t ValueMask = (1ull << Width) - 1;
+        //The words of the bucket the store touches. Bit positions below are relative to the first one.
+        inline static constexpr std::size_t FirstWordByte = Offset/8*8;
+        inline static constexpr std::size_t NumWords = (Offset + Size + 7)/8 - Offset/8;
+        inline static constexpr std::size_t BeginBit = (Offset - FirstWordByte)*8;
+        inline static constexpr std::size_t EndBit = BeginBit + Width*NumRemainders;
+        using Words = std::array<std::uint64_t, NumWords>;
+
+        inline static constexpr std::uint64_t maskBelow(std::size_t bits) {
+            return bits >= 64 ? -1ull : (1ull << bits) - 1;
+        }
+
+        //Bits [begin, end) that fall in word i
+        inline static std::uint64_t rangeMask(std::size_t i, std::size_t begin, std::size_t end) {
+            std::size_t low = std::clamp(begin, i*64, i*64 + 64) - i*64;
+            std::size_t high = std::clamp(end, i*64, i*64 + 64) - i*64;
+            return maskBelow(high) & ~maskBelow(low);
+        }
+
+        inline Words loadWords() const {
+            Words words;
+            std::memcpy(&words, reinterpret_cast<const std::uint8_t*>(&remainders) - (Offset - FirstWordByte), sizeof(Words));
+            return words;
+        }
+
+        inline void storeWords(const Words& words) {
+            std::memcpy(reinterpret_cast<std::uint8_t*>(&remainders) - (Offset - FirstWordByte), &words, sizeof(Words));
+        }
+
+        inline std::uint64_t get(std::size_t loc) const {
+            std::size_t bit = loc*Width;
+            std::uint32_t bytes = 0;
+            for(std::size_t i = bit/8; i <= (bit + Width - 1)/8; i++) {
+                bytes |= static_cast<std::uint32_t>(remainders[i]) << (8*(i - bit/8));
+            }
+            return (bytes >> (bit % 8)) & ValueMask;
+        }
+
+        inline std::uint64_t insert(std::uint64_t remainder, std::size_t loc) {
+            if constexpr (DEBUG) {
+                assert(remainder <= ValueMask);
+                assert(loc <= NumRemainders);
+            }
+            if(loc == NumRemainders) return remainder;
+            std::uint64_t retval = get(NumRemainders-1);
+
+            Words words = loadWords();
+            std::size_t locBit = BeginBit + loc*Width;
+            //Going down so that the word below is still the old one when its top bits get carried in
+            for(std::size_t i = NumWords; i-- > 0;) {
+                std::uint64_t shifted = (words[i] << Width) | (i > 0 ? words[i-1] >> (64 - Width) : 0);
+                words[i] = (words[i] & ~rangeMask(i, locBit, EndBit)) | (shifted & rangeMask(i, locBit + Width, EndBit));
+            }
+            words[locBit/64] |= remainder << (locBit % 64);
+            if(locBit % 64 + Width > 64) {
+                words[locBit/64 + 1] |= remainder >> (64 - locBit % 64);
+            }
+            storeWords(words);
+
+            return retval;
+        }
+
+        //The last remainder keeps its old value, like in the other stores
+        inline void remove(std::size_t loc) {
+            Words words = loadWords();
+            std::size_t locBit = BeginBit + loc*Width;
+            for(std::size_t i = 0; i < NumWords; i++) {
+                std::uint64_t shifted = (words[i] >> Width) | (i + 1 < NumWords ? words[i+1] << (64 - Width) : 0);
+                std::uint64_t moved = rangeMask(i, locBit, EndBit - Width);
+                words[i] = (words[i] & ~moved) | (shifted & moved);
+            }
+            storeWords(words);
+        }
+
+        inline std::uint64_t removeReturn(std::size_t loc) {
+            std::uint64_t retval = get(loc);
+            remove(loc);
+            return retval;
+        }
+
+        inline std::uint64_t removeFirst() {
+            return removeReturn(0);
+        }
+
+        #if PQF_AVX512 && defined(__AVX512VBMI__)
+        inline static constexpr bool FitsInTwoBytes = [] {
+            for(std::size_t i = 0; i < NumRemainders; i++) {
+                if((Offset*8 + i*Width) % 8 + Width > 16) return false;
+            }
+            return true;
+        }();
+        inline static constexpr bool UseVBMI = FitsInTwoBytes;
+        #else
+        inline static constexpr bool UseVBMI = false;
+        #endif
+
+        #if PQF_AVX512 && defined(__AVX512VBMI__)
+        inline static constexpr std::size_t NumVectors = (NumRemainders + 31)/32;
+
+        //Byte pairs that hold remainders 32*v through 32*v+31, and how far each has to be shifted down
+        inline static constexpr __m512i getPermute(std::size_t v) {
+            std::array<unsigned char, 64> bytes{};
+            for(std::size_t lane = 0; lane < 32 && 32*v + lane < NumRemainders; lane++) {
+                std::size_t byte = (Offset*8 + (32*v + lane)*Width)/8;
+                bytes[2*lane] = byte;
+                bytes[2*lane + 1] = (byte + 1) % 64; //Only past the bucket if the remainder fits in the first byte
+            }
+            return std::bit_cast<__m512i>(bytes);
+        }
+
+        inline static constexpr __m512i getShifts(std::size_t v) {
+            std::array<std::uint16_t, 32> shifts{};
+            for(std::size_t lane = 0; lane < 32 && 32*v + lane < NumRemainders; lane++) {
+                shifts[lane] = (Offset*8 + (32*v + lane)*Width) % 8;
+            }
+            return std::bit_cast<__m512i>(shifts);
+        }
+
+        inline static constexpr std::array<m512iWrapper, NumVectors> Permutes = [] {
+            std::array<m512iWrapper, NumVectors> permutes;
+            for(std::size_t v = 0; v < NumVectors; v++) permutes[v] = getPermute(v);
+            return permutes;
+        }();
+        inline static constexpr std::array<m512iWrapper, NumVectors> Shifts = [] {
+            std::array<m512iWrapper, NumVectors> shifts;
+            for(std::size_t v = 0; v < NumVectors; v++) shifts[v] = getShifts(v);
+            return shifts;
+        }();
+
+        inline std::uint64_t matchesVBMI(std::uint64_t remainder) const {
+            const std::uint8_t* bucket = reinterpret_cast<const std::uint8_t*>(&remainders) - Offset;
+            __m512i packedStore;
+            if constexpr (Offset + Size <= 32) {
+                packedStore = _mm512_castsi256_si512(_mm256_load_si256(reinterpret_cast<const __m256i*>(bucket)));
+            }
+            else {
+                packedStore = _mm512_load_si512(bucket);
+            }
+            __m512i remainderVec = _mm512_set1_epi16(remainder);
+            __m512i valueMask = _mm512_set1_epi16(ValueMask);
+            std::uint64_t matches = 0;
+            for(std::size_t v = 0; v < NumVectors; v++) {
+                __m512i lanes = _mm512_srlv_epi16(_mm512_permutexvar_epi8(Permutes[v], packedStore), Shifts[v]);
+                matches |= static_cast<std::uint64_t>(_cvtmask32_u32(_mm512_cmpeq_epi16_mask(_mm512_and_si512(lanes, valueMask), remainderVec))) << (32*v);
+            }
+            return matches & maskBelow(NumRemainders);
+        }
+        #endif
+
+        //Remainders per SWAR compare, and the constants for finding the zero fields of a word of them
+        inline static constexpr std::size_t PerWord = 64/Width;
+        inline static constexpr std::uint64_t FieldOnes = [] {
+            std::uint64_t ones = 0;
+            for(std::size_t i = 0; i < PerWord; i++) ones |= 1ull << (i*Width);
+            return ones;
+        }();
+        inline static constexpr std::uint64_t FieldLowBits = FieldOnes * (ValueMask >> 1);
+        inline static constexpr std::uint64_t FieldHighBits = FieldOnes << (Width - 1);
+
+        inline std::uint64_t matchesSWAR(std::uint64_t remainder) const {
+            Words words = loadWords();
+            std::uint64_t matches = 0;
+            for(std::size_t first = 0; first < NumRemainders; first += PerWord) {
+                std::size_t bit = BeginBit + first*Width;
+                std::uint64_t window = words[bit/64] >> (bit % 64);
+                if(bit % 64 != 0 && bit/64 + 1 < NumWords) {
+                    window |= words[bit/64 + 1] << (64 - bit % 64);
+                }
+                std::uint64_t x = window ^ (remainder * FieldOnes);
+                //A field's high bit ends up set iff any of its bits are, and the add never carries out of the field
+                std::uint64_t zeroFields = ~(((x & FieldLowBits) + FieldLowBits) | x) & FieldHighBits;
+                zeroFields &= maskBelow(std::min(PerWord, NumRemainders - first)*Width);
+                //Usually no more than one match, so just walk them
+                while(zeroFields != 0) {
+                    matches |= 1ull << (first + std::countr_zero(zeroFields)/Width);
+                    zeroFields &= zeroFields - 1;
+                }
+            }
+            return matches;
+        }
+
+        inline std::uint64_t matches(std::uint64_t remainder) const {
+            #if PQF_AVX512 && defined(__AVX512VBMI__)
+            if constexpr (UseVBMI) {
+                return matchesVBMI(remainder);
+            }
+            #endif
+            return matchesSWAR(remainder);
+        }
+
+        inline std::uint64_t queryNonVectorized(std::uint64_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            std::uint64_t retMask = 0;
+            for(std::size_t i{bounds.first}; i < bounds.second; i++) {
+                if(get(i) == remainder) {
+                    retMask |= 1ull << i;
+                }
+            }
+            return retMask;
+        }
+
+        inline std::uint64_t queryVectorizedMask(std::uint64_t remainder, std::uint64_t mask) {
+            return matches(remainder) & mask;
+        }
+
+        inline std::uint64_t queryVectorized(std::uint64_t remainder, std::pair<std::size_t, std::size_t> bounds) {
+            return matches(remainder) & (maskBelow(bounds.second) & ~maskBelow(bounds.first));
+        }
+
+        inline std::uint64_t query(std::uint64_t remainder, std::pair<size_t, size_t> bounds) {
+            if constexpr (DEBUG) {
+                assert(bounds.second <= NumRemainders);
+            }
+            return queryVectorized(remainder, bounds);
+        }
+    };
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<5, NumRemainders, Offset> : RemainderStorePacked<5, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<6, NumRemainders, Offset> : RemainderStorePacked<6, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<7, NumRemainders, Offset> : RemainderStorePacked<7, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<10, NumRemainders, Offset> : RemainderStorePacked<10, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<12, NumRemainders, Offset> : RemainderStorePacked<12, NumRemainders, Offset>{};
+
+    //Wider remainders are split into pieces the 16 and 8 bit stores handle, each compared separately
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<20, NumRemainders, Offset> : RemainderStoreTwoPieces<16, 4, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<24, NumRemainders, Offset> : RemainderStoreTwoPieces<16, 8, NumRemainders, Offset>{};
+
+    template<std::size_t NumRemainders, std::size_t Offset>
+    struct alignas(1) RemainderStore<32, NumRemainders, Offset> : RemainderStoreTwoPieces<16, 16, NumRemainders, Offset>{};
+
+    //Backyard remainders are the frontyard remainder with the TagBits bit tag of which frontyard bucket they came from on top (BackyardQRContainer::TagBits). The tag gets a store of its own so that querySecondPartMask can match on it alone.
+    template<std::size_t TagBits>
+    struct BackyardRemainderStore {
+        template<std::size_t RemainderSize, std::size_t NumRemainders, std::size_t Offset>
+        using Type = RemainderStoreTwoPieces<RemainderSize - TagBits, TagBits, NumRemainders, Offset>;
+    };
+}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef SELECT_HPP
+#define SELECT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include "TestUtility.hpp"
+
+namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
+    //How the mini filter finds the i-th set bit of a word. Pdep is a single instruction on Intel and on AMD from Zen 3 on, but is microcoded (with latency in the hundreds of cycles) on older AMD parts, so the other two avoid BMI2 entirely:
+    //Broadword finds the byte with a multiply based prefix popcount and then does the same trick again within the byte, ByteTable finds the byte the same way and then looks the bit up in a 2KB table.
+    //The scalar backend has no BMI2, so Pdep means ByteTable there, which measured faster than Broadword on every mini filter geometry.
+    enum class SelectType {Pdep, Broadword, ByteTable};
+
+    namespace SelectDetail {
+        inline constexpr std::uint64_t OnesStep8 = 0x0101010101010101ull;
+        inline constexpr std::uint64_t HighBits8 = 0x8080808080808080ull;
+
+        //Byte i holds the popcount of bytes 0 through i
+        inline std::uint64_t bytePrefixPopcounts(std::uint64_t x) {
+            std::uint64_t s = x - ((x >> 1) & 0x5555555555555555ull);
+            s = (s & 0x3333333333333333ull) + ((s >> 2) & 0x3333333333333333ull);
+            s = (s + (s >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+            return s * OnesStep8;
+        }
+
+        //High bit of byte i set if byte i of prefixCounts is more than k. Bytes are at most 64, so adding 0x80 - (k+1) to each never carries into the next one
+        inline std::uint64_t bytesAbove(std::uint64_t prefixCounts, std::uint64_t k) {
+            return (prefixCounts + (0x80 - (k+1)) * OnesStep8) & HighBits8;
+        }
+
+        inline constexpr std::array<std::array<std::uint8_t, 256>, 8> getSelectInByteTable() {
+            std::array<std::array<std::uint8_t, 256>, 8> table{};
+            for(std::size_t byte = 0; byte < 256; byte++) {
+                std::size_t rank = 0;
+                for(std::size_t bit = 0; bit < 8; bit++) {
+                    if((byte >> bit) & 1) {
+                        table[rank][byte] = bit;
+                        rank++;
+                    }
+                }
+            }
+            return table;
+        }
+
+        inline constexpr std::array<std::array<std::uint8_t, 256>, 8> SelectInByteTable = getSelectInByteTable();
+    }
+
+    //Returns x with only its k-th (counting from 0) set bit left, or 0 if x has k or fewer set bits. Same as _pdep_u64(1ull << k, x).
+    template<SelectType Type>
+    inline std::uint64_t selectBit(std::uint64_t x, std::uint64_t k) {
+        using namespace SelectDetail;
+        #if !PQF_SCALAR
+        if constexpr (Type == SelectType::Pdep) {
+            return _pdep_u64(1ull << k, x);
+        }
+        else
+        #endif
+        {
+            std::uint64_t prefixCounts = bytePrefixPopcounts(x);
+            std::uint64_t byteMask = bytesAbove(prefixCounts, k);
+            if(byteMask == 0) return 0;
+            std::uint64_t byteShift = __builtin_ctzll(byteMask) - 7;
+            std::uint64_t rankInByte = k - (((prefixCounts << 8) >> byteShift) & 0xFF);
+            std::uint64_t byte = (x >> byteShift) & 0xFF;
+            if constexpr (Type == SelectType::Broadword) {
+                //Byte j of spread is nonzero iff bit j of the byte is set; turn those into ones and prefix sum them like above
+                std::uint64_t spread = (byte * OnesStep8) & 0x8040201008040201ull;
+                std::uint64_t bitPrefixCounts = (((spread + 0x7F7F7F7F7F7F7F7Full) & HighBits8) >> 7) * OnesStep8;
+                return 1ull << (byteShift + (__builtin_ctzll(bytesAbove(bitPrefixCounts, rankInByte)) >> 3));
+            }
+            else {
+                return 1ull << (byteShift + SelectInByteTable[rankInByte][byte]);
+            }
+        }
+    }
+}
+}
+
+#endif
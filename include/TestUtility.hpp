@@ -3,16 +3,57 @@
 
 #include <iostream>
 #include <cstddef>
-#include <immintrin.h>
 
 // #define __AVX512BW__
 
+//Which bucket kernels get compiled. Follows the compiler flags unless defined beforehand, which the dispatch translation units do (along with a target pragma) so that one binary can hold both the AVX512 and the AVX2 kernels.
+#ifndef PQF_AVX512
+#ifdef __AVX512BW__
+#define PQF_AVX512 1
+#else
+#define PQF_AVX512 0
+#endif
+#endif
+
+//Portable backend with no intrinsics at all (SWAR compares and plain shifts), for targets without AVX2 and BMI2. Picked automatically when the compiler targets neither, so a plain -O3 build works anywhere; define it to 1 to force it.
+#ifndef PQF_SCALAR
+#if PQF_AVX512 || (defined(__AVX2__) && defined(__BMI2__))
+#define PQF_SCALAR 0
+#else
+#define PQF_SCALAR 1
+#endif
+#endif
+
+#if PQF_AVX512 && PQF_SCALAR
+#error "PQF_AVX512 and PQF_SCALAR are mutually exclusive"
+#endif
+
+#if !PQF_SCALAR
+#include <immintrin.h>
+#endif
+
+//Everything ISA specific lives in an inline namespace named after the ISA, so the different sets of instantiations never collide at link time
+#if PQF_AVX512
+#define PQF_ISA_NAMESPACE AVX512
+#elif PQF_SCALAR
+#define PQF_ISA_NAMESPACE Scalar
+#else
+#define PQF_ISA_NAMESPACE AVX2
+#endif
+
+//The AVX512 remainder stores shift remainders on insert and remove with vpexpand/vpcompress (VBMI2, which those kernels already need) and masks built in registers. Define this to 1 to go back to the precomputed shuffle vectors and masks, which cost several KB of constants per store type that compete with the buckets for L1.
+#ifndef PQF_REMAINDER_STORE_TABLES
+#define PQF_REMAINDER_STORE_TABLES 0
+#endif
+
 namespace PQF {
+inline namespace PQF_ISA_NAMESPACE {
     constexpr bool DEBUG = false;
     constexpr bool PARTIAL_DEBUG = false;
     constexpr bool NEW_HASH = false;
     constexpr bool DIAGNOSTICS = false;
 
+    #if !PQF_SCALAR
     struct alignas(16) m128iWrapper {
         static constexpr __m128i zero = {0, 0};
         __m128i m;
@@ -20,6 +61,7 @@ namespace PQF {
         constexpr operator __m128i&() {return m;}
         constexpr operator __m128i() const {return m;}
     };
+    #endif
 
     // struct alignas(64) m512iWrapper {
     //     static constexpr __m512i zero = {0, 0, 0, 0, 0, 0, 0, 0};
@@ -29,6 +71,7 @@ namespace PQF {
     //     constexpr operator __m512i() const {return m;}
     // };
 }
+}
 
 void printBinaryUInt64(uint64_t x, bool newline=false, int divider=64);
 // void print_vec(__m512i X, bool binary, int divider=64);
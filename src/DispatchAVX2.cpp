@@ -0,0 +1,9 @@
+//The AVX2 kernels. PQF_AVX512 is forced off so this stays the fallback even if the compiler flags enable AVX512, but the file itself still has to be built for the x86-64-v3 baseline (as the PQFDispatch target does) to be safe to run on AVX2 only CPUs.
+#define PQF_AVX512 0
+#include "DispatchedFilterImpl.hpp"
+
+namespace PQF {
+    std::unique_ptr<FilterInterface> makeFilterAVX2(DispatchedConfig config, std::size_t N) {
+        return AVX2::makeISAFilter(config, N);
+    }
+}
@@ -0,0 +1,36 @@
+//The AVX512 kernels, compiled into a binary built for the AVX2 baseline.
+//The target pragma only covers the filter headers. Every standard header they use is included before it, so the standard library's inline functions get the baseline target; otherwise the linker could pick AVX512 copies of them for the AVX2 path.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "DispatchedFilter.hpp"
+
+#define PQF_AVX512 1
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vl,avx512dq,avx512cd,avx512vbmi,avx512vbmi2,avx512bitalg")
+#include "DispatchedFilterImpl.hpp"
+#pragma GCC pop_options
+
+namespace PQF {
+    std::unique_ptr<FilterInterface> makeFilterAVX512(DispatchedConfig config, std::size_t N) {
+        return AVX512::makeISAFilter(config, N);
+    }
+}
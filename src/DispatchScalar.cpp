@@ -0,0 +1,10 @@
+//The scalar kernels, with no intrinsics. Both vector backends are forced off so that this stays the fallback whatever the compiler flags enable; the PQFDispatch target builds it for plain x86-64 so it runs on any CPU.
+#define PQF_AVX512 0
+#define PQF_SCALAR 1
+#include "DispatchedFilterImpl.hpp"
+
+namespace PQF {
+    std::unique_ptr<FilterInterface> makeFilterScalar(DispatchedConfig config, std::size_t N) {
+        return Scalar::makeISAFilter(config, N);
+    }
+}
@@ -0,0 +1,37 @@
+#include <stdexcept>
+#include "DispatchedFilter.hpp"
+
+namespace PQF {
+    ISA detectISA() {
+        __builtin_cpu_init();
+        //Every extension src/DispatchAVX512.cpp compiles the filter for
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512cd")
+            && __builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("avx512bitalg")) {
+            return ISA::AVX512;
+        }
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+            return ISA::AVX2;
+        }
+        return ISA::Scalar;
+    }
+
+    std::unique_ptr<FilterInterface> makeDispatchedFilter(DispatchedConfig config, std::size_t N, std::optional<ISA> isa) {
+        ISA bestISA = detectISA();
+        ISA chosenISA = isa.value_or(bestISA);
+        if(chosenISA == ISA::AVX512 && bestISA != ISA::AVX512) {
+            throw std::invalid_argument("This CPU does not support the AVX512 extensions the filter needs");
+        }
+        if(chosenISA == ISA::AVX2 && bestISA == ISA::Scalar) {
+            throw std::invalid_argument("This CPU does not support the AVX2 and BMI2 extensions the filter needs");
+        }
+        if(chosenISA == ISA::AVX512) {
+            return makeFilterAVX512(config, N);
+        }
+        else if(chosenISA == ISA::AVX2) {
+            return makeFilterAVX2(config, N);
+        }
+        else {
+            return makeFilterScalar(config, N);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <vector>
+
+#include "ConfigOptimizer.hpp"
+
+using namespace PQF;
+using namespace std;
+
+//The model should land on the hand tuned geometries (the ratios are its own)
+static_assert(OptimalGeometry<8, 32>.BucketNumMiniBuckets == 22 && OptimalGeometry<8, 32>.FrontyardBucketCapacity == 26 && OptimalGeometry<8, 32>.BackyardBucketCapacity == 18);
+static_assert(OptimalGeometry<8, 32, 32, true>.BucketNumMiniBuckets == 21 && OptimalGeometry<8, 32, 32, true>.FrontyardBucketCapacity == 26);
+static_assert(OptimalGeometry<8, 64>.BucketNumMiniBuckets == 62 && OptimalGeometry<8, 64>.FrontyardBucketCapacity == 50 && OptimalGeometry<8, 64>.BackyardBucketCapacity == 34);
+static_assert(OptimalGeometry<16, 64>.BucketNumMiniBuckets == 36 && OptimalGeometry<16, 64>.FrontyardBucketCapacity == 28 && OptimalGeometry<16, 64>.BackyardBucketCapacity == 22);
+static_assert(OptimalGeometry<16, 64, 64, true>.BucketNumMiniBuckets == 35);
+//And on the geometries of the aliases for the other widths
+static_assert(OptimalGeometry<5, 64>.BucketNumMiniBuckets == 65 && OptimalGeometry<5, 64>.FrontyardBucketCapacity == 63 && OptimalGeometry<5, 64>.BackyardBucketCapacity == 44);
+static_assert(OptimalGeometry<12, 64>.BucketNumMiniBuckets == 44 && OptimalGeometry<12, 64>.FrontyardBucketCapacity == 36 && OptimalGeometry<12, 64>.BackyardBucketCapacity == 27);
+static_assert(OptimalGeometry<24, 64>.BucketNumMiniBuckets == 12 && OptimalGeometry<24, 64>.BackyardBucketCapacity == 16 && OptimalGeometry<24, 64>.FrontyardToBackyardRatio == 6);
+//And of the 128 byte bucket ones
+static_assert(OptimalGeometry<16, 128, 64>.BucketNumMiniBuckets == 55 && OptimalGeometry<16, 128, 64>.FrontyardBucketCapacity == 57 && OptimalGeometry<16, 128, 64>.BackyardBucketCapacity == 21 && OptimalGeometry<16, 128, 64>.FrontyardToBackyardRatio == 5);
+static_assert(OptimalGeometry<16, 128, 64, true>.BucketNumMiniBuckets == 54);
+
+template<size_t SizeRemainders, size_t FrontyardBucketSize, size_t BackyardBucketSize = FrontyardBucketSize, bool Threaded = false>
+void testOptimizedFilter(mt19937& generator, size_t N) {
+    constexpr FilterGeometry g = OptimalGeometry<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, Threaded>;
+    using FT = OptimizedPQF<SizeRemainders, FrontyardBucketSize, BackyardBucketSize, false, Threaded>;
+    cout << "Testing " << SizeRemainders << " bit remainders, " << FrontyardBucketSize << "/" << BackyardBucketSize << " byte buckets" << (Threaded ? ", threaded" : "") << ": ";
+    cout << g.BucketNumMiniBuckets << " mini buckets, capacities " << g.FrontyardBucketCapacity << "/" << g.BackyardBucketCapacity << ", ratio " << g.FrontyardToBackyardRatio;
+    cout << ", predicted " << g.bitsPerKey << " bits per key (" << g.overheadBits << " over the minimum)" << endl;
+
+    //Filled to a bit below the load the geometry was planned for, which is where insert failures start to become possible (the first one came at 0.97 of it at the earliest, in a few hundred runs).
+    //Leaves out the keys of the few frontyard buckets whose two backyard choices are the same bucket (see NEW_HASH), which the model does not account for and which run out of room well before the rest of the filter
+    constexpr double FillLoad = 0.93;
+    double load = FillLoad*g.load;
+    FT filter(N);
+    vector<size_t> keys(N*load);
+    vector<size_t> otherKeys(N*load);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    for(size_t i{0}; i < keys.size(); i++) {
+        do {
+            keys[i] = keyDist(generator) % filter.range;
+        } while(!filter.backyardChoicesDistinct(keys[i]));
+        otherKeys[i] = keyDist(generator) % filter.range;
+    }
+
+    for(size_t key: keys) {
+        [[maybe_unused]] bool inserted = filter.insert(key);
+        assert(inserted);
+    }
+    size_t falsePositives = 0;
+    for(size_t i{0}; i < keys.size(); i++) {
+        assert(filter.query(keys[i]));
+        falsePositives += filter.query(otherKeys[i]);
+    }
+    for(size_t i{0}; i < keys.size()/2; i++) {
+        filter.remove(keys[i]);
+    }
+    for(size_t i{keys.size()/2}; i < keys.size(); i++) {
+        assert(filter.query(keys[i]));
+    }
+    cout << "Actual " << filter.sizeFilter()*8.0/keys.size() << " bits per key at " << load << " load, false positive rate " << ((double)falsePositives)/keys.size() << endl;
+}
+
+int main(int argc, char* argv[]) {
+    random_device rd;
+    mt19937 generator (rd());
+
+    size_t N = 1ull << 20;
+    if(argc > 1) {
+        N = (1ull << atoi(argv[1]));
+    }
+
+    testOptimizedFilter<8, 32>(generator, N);
+    testOptimizedFilter<8, 64>(generator, N);
+    testOptimizedFilter<8, 32, 64>(generator, N);
+    testOptimizedFilter<8, 32, 32, true>(generator, N);
+    testOptimizedFilter<16, 64>(generator, N);
+    //Geometries with no hand tuned alias
+    testOptimizedFilter<16, 32>(generator, N);
+    testOptimizedFilter<16, 32, 64>(generator, N);
+    testOptimizedFilter<16, 64, 64, true>(generator, N);
+    testOptimizedFilter<16, 128, 64>(generator, N);
+    testOptimizedFilter<16, 128, 64, true>(generator, N);
+    //Packed and multi piece remainder stores
+    testOptimizedFilter<7, 64>(generator, N);
+    testOptimizedFilter<12, 32>(generator, N);
+    testOptimizedFilter<20, 64>(generator, N);
+    testOptimizedFilter<32, 64>(generator, N);
+}
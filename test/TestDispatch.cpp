@@ -0,0 +1,128 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include "DispatchedFilter.hpp"
+#include "PartitionQuotientFilter.hpp"
+
+//Build with the x86-64-v3 baseline and link src/DispatchedFilter.cpp, src/DispatchAVX512.cpp, src/DispatchAVX2.cpp and src/DispatchScalar.cpp
+
+using namespace std;
+using namespace PQF;
+
+double nsPerKey(std::function<void(void)> f, size_t N) {
+    auto start = chrono::high_resolution_clock::now();
+    f();
+    auto end = chrono::high_resolution_clock::now();
+    return ((double)chrono::duration_cast<chrono::nanoseconds>(end-start).count())/N;
+}
+
+const char* isaName(ISA isa) {
+    return isa == ISA::AVX512 ? "AVX512" : (isa == ISA::AVX2 ? "AVX2" : "Scalar");
+}
+
+//FT is the same configuration as config, compiled directly for whatever this file was compiled for, to compare against
+template<typename FT>
+void testDispatch(mt19937& generator, size_t N, DispatchedConfig config) {
+    //The scalar kernels run on any CPU, so they always get checked against the vector ones
+    std::vector<ISA> isas{ISA::Scalar, ISA::AVX2};
+    if(detectISA() == ISA::AVX512) {
+        isas.push_back(ISA::AVX512);
+    }
+    assert(makeDispatchedFilter(config, N)->isa() == detectISA());
+
+    FT direct(N);
+    vector<size_t> keys(N*0.85);
+    vector<size_t> otherKeys(N*0.85);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    for(size_t i{0}; i < keys.size(); i++) {
+        keys[i] = keyDist(generator) % direct.range;
+        otherKeys[i] = keyDist(generator) % direct.range;
+    }
+    size_t numKeys = keys.size();
+
+    //Every ISA has to build the exact same filter, so they must agree on every query, false positives included
+    std::vector<std::unique_ptr<FilterInterface>> filters;
+    for(ISA isa: isas) {
+        filters.push_back(makeDispatchedFilter(config, N, isa));
+        assert(filters.back()->isa() == isa && filters.back()->range() == direct.range);
+    }
+    for(size_t i{0}; i < numKeys; i++) {
+        bool inserted = direct.insert(keys[i]);
+        for(auto& filter: filters) {
+            assert(filter->insert(keys[i]) == inserted);
+        }
+    }
+    for(size_t i{0}; i < numKeys; i++) {
+        bool found = direct.query(otherKeys[i]);
+        for(auto& filter: filters) {
+            assert(filter->query(keys[i]));
+            assert(filter->query(otherKeys[i]) == found);
+        }
+    }
+    for(size_t i{0}; i < numKeys/2; i++) {
+        direct.remove(keys[i]);
+        for(auto& filter: filters) {
+            filter->remove(keys[i]);
+        }
+    }
+    for(size_t i{0}; i < numKeys; i++) {
+        bool found = direct.query(otherKeys[i]);
+        for(auto& filter: filters) {
+            assert(filter->query(otherKeys[i]) == found);
+            assert(i < numKeys/2 || filter->query(keys[i]));
+        }
+    }
+
+    //The virtual call costs the most when it is paid per key; with the batch functions it is paid once per batch. So each way of calling is compared against the same calls on the filter compiled in directly
+    vector<bool> status(numKeys);
+    size_t found = 0;
+    double directInsert, directQuery, directBatchInsert, directBatchQuery;
+    {
+        FT perKey(N);
+        directInsert = nsPerKey([&] () -> void {for(size_t key: keys) perKey.insert(key);}, numKeys);
+        directQuery = nsPerKey([&] () -> void {for(size_t key: keys) found += perKey.query(key);}, numKeys);
+        FT batched(N);
+        directBatchInsert = nsPerKey([&] () -> void {batched.insertBatch(keys, status, numKeys);}, numKeys);
+        directBatchQuery = nsPerKey([&] () -> void {batched.queryBatch(keys, status, numKeys);}, numKeys);
+        found += std::count(status.begin(), status.end(), true);
+    }
+    cout << "Direct per key: " << directInsert << "ns per insert, " << directQuery << "ns per query" << endl;
+    cout << "Direct batch: " << directBatchInsert << "ns per insert, " << directBatchQuery << "ns per query" << endl;
+    for(ISA isa: isas) {
+        auto perKey = makeDispatchedFilter(config, N, isa);
+        double perKeyInsert = nsPerKey([&] () -> void {for(size_t key: keys) perKey->insert(key);}, numKeys);
+        double perKeyQuery = nsPerKey([&] () -> void {for(size_t key: keys) found += perKey->query(key);}, numKeys);
+        auto batched = makeDispatchedFilter(config, N, isa);
+        double batchInsert = nsPerKey([&] () -> void {batched->insertBatch(keys, status, numKeys);}, numKeys);
+        double batchQuery = nsPerKey([&] () -> void {batched->queryBatch(keys, status, numKeys);}, numKeys);
+        found += std::count(status.begin(), status.end(), true);
+        cout << isaName(isa) << " dispatched per key: " << perKeyInsert << "ns per insert, " << perKeyQuery << "ns per query (" << perKeyInsert/directInsert << "x, " << perKeyQuery/directQuery << "x direct)" << endl;
+        cout << isaName(isa) << " dispatched batch: " << batchInsert << "ns per insert, " << batchQuery << "ns per query (" << batchInsert/directBatchInsert << "x, " << batchQuery/directBatchQuery << "x direct)" << endl;
+    }
+    assert(found == numKeys * (2 + 2*isas.size()));
+}
+
+int main(int argc, char* argv[]) {
+    random_device rd;
+    mt19937 generator (rd());
+
+    size_t N = 1ull << 22;
+    if(argc > 1) {
+        N = (1ull << atoi(argv[1]));
+    }
+
+    cout << "Detected " << isaName(detectISA()) << endl;
+    cout << "Testing PQF_8_22" << endl;
+    testDispatch<PQF_8_22>(generator, N, DispatchedConfig::PQF_8_22);
+    cout << "Testing PQF_8_53" << endl;
+    testDispatch<PQF_8_53>(generator, N, DispatchedConfig::PQF_8_53);
+    cout << "Testing PQF_16_36" << endl;
+    testDispatch<PQF_16_36>(generator, N, DispatchedConfig::PQF_16_36);
+    cout << "Testing PQF_8_52_T" << endl;
+    testDispatch<PQF_8_52_T>(generator, N, DispatchedConfig::PQF_8_52_T);
+}
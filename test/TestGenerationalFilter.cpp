@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <vector>
+#include <set>
+
+#include "GenerationalFilter.hpp"
+
+using namespace PQF;
+using namespace std;
+
+template<typename FT, size_t NumGenerations>
+void testGenerationalFilter(mt19937& generator, size_t N, size_t numExpirations) {
+    cout << "Testing generational filter with " << NumGenerations << " generations" << endl;
+    GenerationalFilter<FT, NumGenerations> gf(N*1.2);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+
+    vector<vector<size_t>> keysPerGeneration;
+    for(size_t e{0}; e < numExpirations; e++) {
+        keysPerGeneration.push_back(vector<size_t>(N));
+        for(size_t& key: keysPerGeneration.back()) {
+            key = keyDist(generator) % gf.range;
+            assert(gf.insert(key));
+        }
+
+        //Everything from the live generations should be there, and what has expired should only be there if a live generation also has the same hash
+        size_t firstLive = keysPerGeneration.size() > NumGenerations ? keysPerGeneration.size() - NumGenerations : 0;
+        set<size_t> liveKeys;
+        for(size_t g{firstLive}; g < keysPerGeneration.size(); g++) {
+            liveKeys.insert(keysPerGeneration[g].begin(), keysPerGeneration[g].end());
+        }
+        for(size_t key: liveKeys) {
+            assert(gf.query(key));
+        }
+        for(size_t g{0}; g < firstLive; g++) {
+            for(size_t key: keysPerGeneration[g]) {
+                assert(gf.query(key) == (liveKeys.count(key) > 0));
+            }
+        }
+
+        vector<size_t> liveKeysVec(liveKeys.begin(), liveKeys.end());
+        vector<bool> status(liveKeysVec.size());
+        gf.queryBatch(liveKeysVec, status, liveKeysVec.size());
+        for(size_t i{0}; i < status.size(); i++) {
+            assert(status[i]);
+        }
+
+        if(e % 2 == 0) {
+            gf.prepareSpare(); //otherwise expire does it
+        }
+        gf.expire();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    random_device rd;
+    mt19937 generator (rd());
+
+    size_t N = (1ull << 14)*90/100;
+    if(argc > 1) {
+        N = (1ull << atoi(argv[1]));
+    }
+
+    testGenerationalFilter<PQF_8_22, 3>(generator, N, 7);
+    testGenerationalFilter<PQF_16_36, 4>(generator, N, 9);
+    testGenerationalFilter<PQF_8_53, 1>(generator, N, 3);
+}
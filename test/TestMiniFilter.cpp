@@ -3,18 +3,21 @@
 #include <array>
 #include <random>
 #include <set>
+#include <vector>
+#include <chrono>
+#include <functional>
 #include "MiniFilter.hpp"
 #include "TestUtility.hpp"
 
 using namespace std;
 using namespace PQF;
 
-template<size_t NumKeys, size_t NumMiniBuckets>
+template<size_t NumKeys, size_t NumMiniBuckets, SelectType Select = SelectType::Pdep>
 struct alignas(1) FakeBucket {
     static constexpr size_t NumBytes = (NumKeys+NumMiniBuckets+7)/8;
     static constexpr size_t NumUllongs = (NumBytes+7)/8;
     static constexpr size_t NumExtraBytes = NumUllongs*8 + 10 - NumBytes; //just some random extra bytes to make sure the filter isn't doing weird stuff
-    MiniFilter<NumKeys, NumMiniBuckets> filterBytes;
+    MiniFilter<NumKeys, NumMiniBuckets, false, Select> filterBytes;
     std::array<uint8_t, NumExtraBytes> extraBytes;
     
     // std::array<uint64_t, NumUllongs + 1> randomData;
@@ -35,7 +38,7 @@ struct alignas(1) FakeBucket {
         }
 
         basicFunctionTestWrapper([&] () -> void {
-            filterBytes = MiniFilter<NumKeys, NumMiniBuckets>();
+            filterBytes = MiniFilter<NumKeys, NumMiniBuckets, false, Select>();
         });
     }
 
@@ -100,10 +103,10 @@ struct alignas(1) FakeBucket {
 
 //TODO: Just changed what MiniFilter insert returns, so verify it returns the correct mini bucket of the thing that overflowed (we know the key index is just the highest one).
 //In fact I can guarantee it *doesn't* return the right thing.
-template<size_t NumKeys, size_t NumMiniBuckets>
+template<size_t NumKeys, size_t NumMiniBuckets, SelectType Select = SelectType::Pdep>
 void testBucket(mt19937& generator) {
     cout << "Testing with " << NumKeys << " keys and " << NumMiniBuckets << " mini buckets." << endl;
-    FakeBucket<NumKeys, NumMiniBuckets> temp(generator);
+    FakeBucket<NumKeys, NumMiniBuckets, Select> temp(generator);
     // uniform_int_distribution<uint8_t> miniBucketDist(0, NumMiniBuckets);
     cout << "Testing just with putting all in the front." << endl;
     cout << "Testing filling the mini filter: ";
@@ -127,7 +130,7 @@ void testBucket(mt19937& generator) {
 
     //Bad random cause it favors longer chains and isn't uniform but whatever we'll just keep it here as a test
     cout << "Testing random inserts." << endl;
-    temp = FakeBucket<NumKeys, NumMiniBuckets>(generator);
+    temp = FakeBucket<NumKeys, NumMiniBuckets, Select>(generator);
     cout << "Testing filling the mini filter: ";
     for(size_t i{1}; i <= NumKeys; i++) {
         // cout << i << endl;
@@ -156,7 +159,7 @@ void testBucket(mt19937& generator) {
     cout << "pass" << endl;
 
     cout << "Testing inserting randomly properly, then querying elements afterwards: ";
-    temp = FakeBucket<NumKeys, NumMiniBuckets>(generator);
+    temp = FakeBucket<NumKeys, NumMiniBuckets, Select>(generator);
     array<size_t, NumMiniBuckets> sizeEachMiniBucket{};
     for(size_t i{0}; i < NumKeys; i++) {
         uniform_int_distribution<size_t> miniBucketIndexDist(0, NumMiniBuckets-1);
@@ -252,7 +255,7 @@ void testBucket(mt19937& generator) {
     }
 
     cout << "Testing if overflow values are correct: ";
-    temp = FakeBucket<NumKeys, NumMiniBuckets>(generator);
+    temp = FakeBucket<NumKeys, NumMiniBuckets, Select>(generator);
     multiset<uint64_t> miniBucketIndices{};
     for(size_t i{1}; i <= NumKeys; i++) {
         uniform_int_distribution<size_t> miniBucketIndexDist(0, NumMiniBuckets-1);
@@ -279,6 +282,91 @@ void testBucket(mt19937& generator) {
     cout << endl;
 }
 
+const char* selectName(SelectType select) {
+    switch(select) {
+        case SelectType::Pdep: return "pdep";
+        case SelectType::Broadword: return "broadword";
+        case SelectType::ByteTable: return "byte table";
+    }
+    return "";
+}
+
+uint64_t referenceSelectBit(uint64_t x, uint64_t k) {
+    #if PQF_SCALAR
+    for(; x != 0; x &= x-1, k--) {
+        if(k == 0) return x & -x;
+    }
+    return 0;
+    #else
+    return _pdep_u64(1ull << k, x);
+    #endif
+}
+
+//Every select has to agree with pdep, including returning 0 when asking for more set bits than there are
+template<SelectType Select>
+void testSelectBit(mt19937& generator) {
+    cout << "Testing " << selectName(Select) << " select against pdep: ";
+    uniform_int_distribution<uint64_t> wordDist(0, -1ull);
+    uniform_int_distribution<size_t> shiftDist(0, 63);
+    for(size_t i{0}; i < 100000; i++) {
+        //Mix in sparse and dense words so every byte position gets hit with every in byte rank
+        uint64_t x = wordDist(generator);
+        if(i % 3 == 1) x &= wordDist(generator) & wordDist(generator);
+        if(i % 3 == 2) x |= wordDist(generator) | wordDist(generator);
+        x >>= shiftDist(generator);
+        for(uint64_t k{0}; k < 64; k++) {
+            assert(selectBit<Select>(x, k) == referenceSelectBit(x, k));
+        }
+    }
+    assert(selectBit<Select>(0, 0) == 0 && selectBit<Select>(-1ull, 63) == (1ull << 63));
+    cout << "pass" << endl;
+}
+
+//Times the two mini filter queries that do a select (the bounds of a mini bucket and which mini bucket a key is in) over a big array of mini filters filled to 90%, so it measures the select and not the cache
+template<size_t NumKeys, size_t NumMiniBuckets, SelectType Select>
+double benchmarkSelect(uint64_t seed, uint64_t& checksum) {
+    using MF = MiniFilter<NumKeys, NumMiniBuckets, false, Select>;
+    constexpr size_t NumFilters = 1024;
+    constexpr size_t NumQueries = 1ull << 22;
+    mt19937 generator(seed);
+    std::vector<MF> filters(NumFilters);
+    uniform_int_distribution<size_t> miniBucketDist(0, NumMiniBuckets-1);
+    for(MF& filter: filters) {
+        for(size_t i{0}; i < NumKeys*9/10; i++) {
+            size_t miniBucketIndex = miniBucketDist(generator);
+            filter.insert(miniBucketIndex, filter.queryMiniBucketBeginning(miniBucketIndex));
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> queries(NumQueries);
+    uniform_int_distribution<size_t> filterDist(0, NumFilters-1);
+    uniform_int_distribution<size_t> keyDist(0, NumKeys*9/10-1);
+    for(auto& [filterIndex, index]: queries) {
+        filterIndex = filterDist(generator);
+        index = miniBucketDist(generator) | (keyDist(generator) << 8);
+    }
+
+    uint64_t sum = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for(auto [filterIndex, index]: queries) {
+        auto [lowerMask, upperMask] = filters[filterIndex].queryMiniBucketBoundsMask(index & 255);
+        sum += (lowerMask ^ upperMask) + filters[filterIndex].queryWhichMiniBucket(index >> 8);
+    }
+    auto end = chrono::high_resolution_clock::now();
+    checksum = sum;
+    return ((double)chrono::duration_cast<chrono::nanoseconds>(end-start).count())/NumQueries;
+}
+
+template<size_t NumKeys, size_t NumMiniBuckets>
+void benchmarkSelects() {
+    uint64_t seed = random_device()();
+    uint64_t pdepChecksum, broadwordChecksum, byteTableChecksum;
+    double pdepTime = benchmarkSelect<NumKeys, NumMiniBuckets, SelectType::Pdep>(seed, pdepChecksum);
+    double broadwordTime = benchmarkSelect<NumKeys, NumMiniBuckets, SelectType::Broadword>(seed, broadwordChecksum);
+    double byteTableTime = benchmarkSelect<NumKeys, NumMiniBuckets, SelectType::ByteTable>(seed, byteTableChecksum);
+    assert(pdepChecksum == broadwordChecksum && pdepChecksum == byteTableChecksum);
+    cout << NumKeys << " keys, " << NumMiniBuckets << " mini buckets: " << pdepTime << "ns pdep, " << broadwordTime << "ns broadword, " << byteTableTime << "ns byte table per query pair" << endl;
+}
+
 int main() {
     #ifdef __AVX512BW__
         printf("AVX-512BW is supported at compile time.\n");
@@ -290,10 +378,34 @@ int main() {
     random_device rd;
     mt19937 generator (rd());
 
+    testSelectBit<SelectType::Broadword>(generator);
+    testSelectBit<SelectType::ByteTable>(generator);
+
     for(size_t i{0}; i < 5; i++) {
         testBucket<51, 52>(generator);
         testBucket<25, 26>(generator);
+        testBucket<51, 52, SelectType::Broadword>(generator);
+        testBucket<25, 26, SelectType::Broadword>(generator);
+        testBucket<51, 52, SelectType::ByteTable>(generator);
+        testBucket<25, 26, SelectType::ByteTable>(generator);
+        //Mini filters past two words, for 128 byte buckets
+        testBucket<54, 106>(generator);
+        testBucket<48, 208>(generator);
+        testBucket<54, 106, SelectType::Broadword>(generator);
         // testBucket<75, 61>(generator);
         // testBucket<400, 3>(generator); //Just to hit extreme cases that I account for but aren't really all that necessary in the actual filter design lol
     }
+
+    //Frontyard and backyard mini filters of the shipped configurations
+    cout << "Benchmarking select variants" << endl;
+    benchmarkSelects<26, 22>(); //PQF_8_22
+    benchmarkSelects<18, 22>();
+    benchmarkSelects<25, 31>(); //PQF_8_31
+    benchmarkSelects<17, 31>();
+    benchmarkSelects<51, 53>(); //PQF_8_53
+    benchmarkSelects<35, 53>();
+    benchmarkSelects<50, 62>(); //PQF_8_62
+    benchmarkSelects<34, 62>();
+    benchmarkSelects<28, 36>(); //PQF_16_36
+    benchmarkSelects<22, 36>();
 }
\ No newline at end of file
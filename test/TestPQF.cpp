@@ -4,6 +4,12 @@
 #include <vector>
 #include <optional>
 #include <chrono>
+#include <algorithm>
+#include <set>
+#include <iterator>
+#include <thread>
+#include <fstream>
+#include <numeric>
 
 #include "PartitionQuotientFilter.hpp"
 
@@ -11,8 +17,8 @@ using namespace PQF;
 using namespace std;
 
 template<typename FT>
-void testFilter(mt19937 generator, size_t N) {
-    FT pf(N*1.2);
+void testFilter(mt19937 generator, size_t N, double slack = 1.2) {
+    FT pf(N*slack);
     std::cout << "Realized N: " << N << ", size of filter: " << pf.sizeFilter() << endl;
 
     vector<size_t> keys(N);
@@ -120,10 +126,601 @@ void testFilter(mt19937 generator, size_t N) {
     cout << ms << "ms for removing all the keys, or " << (ms * 1e6 / N) << "ns per removal" << endl;
 }
 
+template<typename FT>
+void testEnumeration(mt19937 generator, size_t N, double slack = 1.2) {
+    FT pf(N*slack);
+    vector<size_t> keys(N);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    for(size_t i{0}; i < N; i++) {
+        keys[i] = keyDist(generator) % pf.range;
+        assert(pf.insert(keys[i]));
+    }
+    sort(keys.begin(), keys.end());
+
+    cout << "Checking that enumerating the filter gives back exactly the inserted keys" << endl;
+    vector<size_t> enumerated;
+    pf.forEachHash([&](uint64_t hash) {enumerated.push_back(hash);});
+    sort(enumerated.begin(), enumerated.end());
+    assert(enumerated == keys);
+
+    constexpr size_t NumThreads = 4;
+    vector<vector<size_t>> threadEnumerated(NumThreads);
+    pf.forEachHashParallel([&](size_t t, uint64_t hash) {threadEnumerated[t].push_back(hash);}, NumThreads);
+    enumerated.clear();
+    for(auto& v: threadEnumerated) {
+        enumerated.insert(enumerated.end(), v.begin(), v.end());
+    }
+    sort(enumerated.begin(), enumerated.end());
+    assert(enumerated == keys);
+}
+
+template<typename FT>
+vector<size_t> enumerateFilter(const FT& pf) {
+    vector<size_t> hashes;
+    pf.forEachHash([&](uint64_t hash) {hashes.push_back(hash);});
+    sort(hashes.begin(), hashes.end());
+    return hashes;
+}
+
+template<typename FT>
+void testSetOperations(mt19937 generator, size_t N, double slack = 1.2) {
+    FT a(N*slack);
+    FT b(N*slack);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    set<size_t> aKeys, bKeys;
+    for(size_t i{0}; i < N; i++) {
+        size_t key = keyDist(generator) % a.range;
+        if(i % 3 != 2) {
+            assert(a.insert(key));
+            aKeys.insert(key);
+        }
+        if(i % 3 != 0) {
+            assert(b.insert(key));
+            bKeys.insert(key);
+        }
+        if(i % 16 == 0) { //some duplicates, which the set operations should collapse
+            assert(a.insert(key));
+            aKeys.insert(key);
+        }
+    }
+
+    cout << "Checking intersection, difference and distinct union" << endl;
+    vector<size_t> expected;
+    set_intersection(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    assert(FT::intersectSize(a, b) == expected.size());
+    assert(enumerateFilter(FT::intersect(a, b)) == expected);
+
+    expected.clear();
+    set_difference(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    assert(FT::differenceSize(a, b) == expected.size());
+    assert(enumerateFilter(FT::difference(a, b)) == expected);
+
+    expected.clear();
+    set_union(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    assert(FT::unionDistinctSize(a, b) == expected.size());
+    FT u = FT::unionDistinct(a, b);
+    assert(enumerateFilter(u) == expected);
+    for(size_t key: expected) {
+        assert(u.query(key));
+    }
+}
+
+//Keys all with the same quotient, so they all go to one frontyard bucket and its overflow to the same backyard buckets, up to the first one that does not fit
+template<typename FT>
+vector<size_t> fillOneBucket(mt19937& generator, size_t N) {
+    FT probe(N*1.2);
+    size_t remainderRange = probe.range / probe.capacity;
+    size_t quotient = probe.capacity / 2;
+    vector<size_t> remainders(remainderRange);
+    iota(remainders.begin(), remainders.end(), 0);
+    shuffle(remainders.begin(), remainders.end(), generator);
+    vector<size_t> keys;
+    for(size_t remainder: remainders) {
+        size_t key = quotient*remainderRange + remainder;
+        if(!probe.insert(key)) break;
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+//The set operations gather all the hashes of a frontyard bucket, wherever they are stored, into fixed size buffers, so they need to handle a bucket whose overflow filled all of its backyard choices
+template<typename FT>
+size_t testSetOperationsFullOverflow(mt19937 generator, size_t N) {
+    vector<size_t> keys = fillOneBucket<FT>(generator, N);
+    FT a(N*1.2);
+    FT b(N*1.2);
+    vector<size_t> aKeys, bKeys;
+    for(size_t i{0}; i < keys.size(); i++) {
+        assert(a.insert(keys[i]));
+        aKeys.push_back(keys[i]);
+        if(i % 2 == 0) {
+            assert(b.insert(keys[i]));
+            bKeys.push_back(keys[i]);
+        }
+    }
+    sort(aKeys.begin(), aKeys.end());
+    sort(bKeys.begin(), bKeys.end());
+
+    cout << "Checking set operations on a bucket with " << keys.size() << " keys" << endl;
+    assert(FT::intersectSize(a, b) == bKeys.size());
+    assert(enumerateFilter(FT::intersect(a, b)) == bKeys);
+    vector<size_t> expected;
+    set_difference(aKeys.begin(), aKeys.end(), bKeys.begin(), bKeys.end(), back_inserter(expected));
+    assert(FT::differenceSize(a, b) == expected.size());
+    assert(enumerateFilter(FT::difference(a, b)) == expected);
+    assert(FT::unionDistinctSize(a, b) == aKeys.size());
+    assert(enumerateFilter(FT::unionDistinct(a, b)) == aKeys);
+    return keys.size();
+}
+
+template<typename FT>
+void testInsertIfAbsent(mt19937 generator, size_t N, double slack = 1.2) {
+    FT pf(N*slack);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys(N);
+    for(size_t i{0}; i < N; i++) {
+        keys[i] = (i % 4 == 3) ? keys[keyDist(generator) % i] : keyDist(generator) % pf.range;
+    }
+
+    cout << "Checking insertIfAbsent" << endl;
+    set<size_t> inserted;
+    for(size_t i{0}; i < N/2; i++) {
+        assert(pf.insertIfAbsent(keys[i]) == (inserted.insert(keys[i]).second ? 0 : 1));
+    }
+    vector<uint64_t> status(N);
+    pf.insertIfAbsentBatch(vector<size_t>(keys.begin() + N/2, keys.end()), status, N - N/2);
+    for(size_t i{N/2}; i < N; i++) {
+        assert(status[i - N/2] == (inserted.insert(keys[i]).second ? 0 : 1));
+    }
+    assert(enumerateFilter(pf) == vector<size_t>(inserted.begin(), inserted.end()));
+    for(size_t key: inserted) {
+        assert(pf.query(key));
+    }
+}
+
+template<typename FT>
+void testKWayMerge(mt19937 generator, size_t N, size_t numFilters) {
+    vector<FT> filters;
+    for(size_t f{0}; f < numFilters; f++) {
+        filters.emplace_back(N*1.5); //some slack, since a failed insert in any of the inputs fails the test
+    }
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys;
+    for(FT& pf: filters) {
+        for(size_t i{0}; i < N; i++) {
+            keys.push_back(keyDist(generator) % pf.range);
+            assert(pf.insert(keys.back()));
+        }
+    }
+    sort(keys.begin(), keys.end());
+
+    cout << "Checking merging " << numFilters << " filters at once" << endl;
+    vector<const FT*> inputs;
+    for(FT& pf: filters) {
+        inputs.push_back(&pf);
+    }
+    FT merged(inputs);
+    assert(merged.range == filters[0].range);
+    assert(enumerateFilter(merged) == keys);
+    for(size_t key: keys) {
+        assert(merged.query(key));
+    }
+
+    if(numFilters == 2) { //should be the same as the pairwise merge
+        assert(enumerateFilter(FT(filters[0], filters[1])) == keys);
+    }
+}
+
+//Merges a filter that is itself the merge of two with two fresh ones, so the inputs have different capacities and remainder sizes
+template<typename FT>
+void testUnequalMerge(mt19937 generator, size_t N) {
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<FT> filters;
+    vector<size_t> keys;
+    for(size_t f{0}; f < 4; f++) {
+        filters.emplace_back(N*1.5); //some slack, since a failed insert in any of the inputs fails the test
+        for(size_t i{0}; i < N; i++) {
+            keys.push_back(keyDist(generator) % filters[0].range);
+            assert(filters.back().insert(keys.back()));
+        }
+    }
+    sort(keys.begin(), keys.end());
+
+    cout << "Checking merging filters of different sizes" << endl;
+    FT a(filters[0], filters[1]);
+    vector<const FT*> inputs{&filters[2], &a, &filters[3]};
+    FT merged(inputs);
+    assert(merged.capacity == 4*filters[0].capacity);
+    assert(enumerateFilter(merged) == keys);
+    for(size_t key: keys) {
+        assert(merged.query(key));
+    }
+
+    //Merging a single filter with a smaller remainder size just spreads it over a larger filter
+    vector<size_t> someKeys = enumerateFilter(a);
+    FT smallerRemainders(vector<const FT*>{&a}, optional<uint64_t>(3));
+    assert(enumerateFilter(smallerRemainders) == someKeys);
+
+    bool threw = false;
+    try {
+        FT tooLarge(vector<const FT*>{&a, &filters[2]}, optional<uint64_t>(100));
+    }
+    catch(const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    //Filters built from the start with twice and four times the capacity of another, in its range, merge with it directly
+    cout << "Checking merging filters built with a shared range" << endl;
+    FT single(N*1.5);
+    FT twice(2*single.capacity, single.range, false);
+    FT fourTimes(4*single.capacity, single.range, false);
+    assert(twice.capacity == 2*single.capacity && fourTimes.capacity == 4*single.capacity);
+    keys.clear();
+    for(FT* pf: {&single, &twice, &twice, &fourTimes, &fourTimes, &fourTimes, &fourTimes}) {
+        for(size_t i{0}; i < N; i++) {
+            keys.push_back(keyDist(generator) % single.range);
+            assert(pf->insert(keys.back()));
+        }
+    }
+    sort(keys.begin(), keys.end());
+    FT sharedRangeMerge(vector<const FT*>{&single, &twice, &fourTimes});
+    assert(sharedRangeMerge.range == single.range && sharedRangeMerge.capacity == 8*single.capacity);
+    assert(enumerateFilter(sharedRangeMerge) == keys);
+    for(size_t key: keys) {
+        assert(sharedRangeMerge.query(key));
+    }
+}
+
+//Every operation of the filter interface. main runs it on each spill, backyard choice and layout variant ahead of that variant's own checks
+template<typename FT>
+void testAllOperations(mt19937 generator, size_t N) {
+    testFilter<FT>(generator, N);
+    testEnumeration<FT>(generator, N);
+    testSetOperations<FT>(generator, N);
+    testInsertIfAbsent<FT>(generator, N);
+    testKWayMerge<FT>(generator, N, 4);
+    testUnequalMerge<FT>(generator, N);
+}
+
+template<typename FT, typename EagerFT>
+void testLazyBackyard(mt19937 generator, size_t N) {
+    testFilter<FT>(generator, N);
+
+    cout << "Checking the lazily allocated backyard" << endl;
+    FT pf(N*1.2);
+    EagerFT eager(N*1.2);
+    size_t emptySize = pf.sizeFilter();
+    assert(emptySize < eager.sizeFilter());
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys;
+    for(size_t i{0}; i < N/4; i++) { //low enough load that barely anything overflows
+        keys.push_back(keyDist(generator) % pf.range);
+        assert(pf.insert(keys.back()));
+    }
+    assert(pf.sizeFilter() < eager.sizeFilter());
+    for(size_t i{N/4}; i < N; i++) {
+        keys.push_back(keyDist(generator) % pf.range);
+        assert(pf.insert(keys.back()));
+    }
+    FT copy(pf);
+    sort(keys.begin(), keys.end());
+    assert(enumerateFilter(copy) == keys);
+    pf.clear();
+    assert(pf.sizeFilter() == emptySize);
+    assert(enumerateFilter(pf).size() == 0);
+
+    cout << "Checking that lookups in a full frontyard bucket do not allocate the backyard" << endl;
+    //Keys of one quotient up to the one whose overflow allocates a backyard region, so that without it the bucket is full and has nothing in the backyard
+    size_t remainderRange = pf.range / pf.capacity;
+    size_t quotient = pf.capacity / 2;
+    size_t numKeys = 0;
+    for(; pf.sizeFilter() == emptySize; numKeys++) {
+        assert(pf.insert(quotient*remainderRange + numKeys));
+    }
+    FT full(N*1.2);
+    for(size_t i{0}; i+1 < numKeys; i++) {
+        assert(full.insert(quotient*remainderRange + i));
+    }
+    assert(full.sizeFilter() == emptySize);
+    for(size_t i{numKeys}; i < remainderRange; i++) {
+        assert(!full.query(quotient*remainderRange + i));
+        assert(!full.remove(quotient*remainderRange + i));
+    }
+    assert(full.sizeFilter() == emptySize);
+    for(size_t i{0}; i+1 < numKeys; i++) {
+        assert(full.query(quotient*remainderRange + i));
+    }
+}
+
+//Spilling over into the partner bucket should send fewer queries on to the backyard at the same load, and hold keys at a load where the single choice filter runs out of backyard
+template<typename FT, typename SingleFT>
+void testFrontyardSpill(mt19937 generator, size_t N) {
+    cout << "Comparing the backyard lookups with the single choice filter" << endl;
+    FT pf(N*1.2);
+    SingleFT single(N*1.2);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    //Leaves out the keys of the few frontyard buckets whose two backyard choices are the same bucket (see NEW_HASH), as those run out of room at any load, in either filter
+    auto nextKey = [&]() {
+        size_t key;
+        do {
+            key = keyDist(generator);
+        } while(!pf.backyardChoicesDistinct(key % pf.range) || !single.backyardChoicesDistinct(key % single.range));
+        return key;
+    };
+    vector<size_t> keys(N);
+    for(size_t i{0}; i < N; i++) {
+        keys[i] = nextKey();
+        assert(pf.insert(keys[i] % pf.range));
+        assert(single.insert(keys[i] % single.range));
+    }
+    size_t backyardLookups = 0, singleBackyardLookups = 0;
+    for(size_t i{0}; i < N; i++) {
+        uint64_t where = pf.queryWhere(keyDist(generator) % pf.range);
+        backyardLookups += (where & 2) >> 1;
+        where = single.queryWhere(keyDist(generator) % single.range);
+        singleBackyardLookups += (where & 2) >> 1;
+    }
+    cout << "Backyard lookups per random query: " << (double)backyardLookups/N << " against " << (double)singleBackyardLookups/N << endl;
+    assert(backyardLookups < singleBackyardLookups);
+
+    for(size_t& key: keys) {
+        key %= pf.range;
+    }
+    //Up to about 88% load, where the single choice PQF_8_22 fails some inserts in nearly every run, and the spilling filters none
+    size_t singleFailures = 0;
+    for(size_t i{0}; i < N/16; i++) {
+        size_t key = nextKey();
+        assert(pf.insert(key % pf.range));
+        keys.push_back(key % pf.range);
+        singleFailures += !single.insert(key % single.range);
+    }
+    cout << "Failed inserts up to 88% load: 0 against " << singleFailures << endl;
+    for(size_t key: keys) {
+        assert(pf.query(key));
+    }
+    sort(keys.begin(), keys.end());
+    assert(enumerateFilter(pf) == keys);
+}
+
+//With more backyard choices, delete/insert churn near full load should not pile up overflow in some backyard buckets the way it does with two
+template<typename FT, typename TwoChoiceFT>
+void testBackyardChoices(mt19937 generator, size_t N) {
+    //One bucket can overflow into more backyard buckets, so more of its keys fit
+    assert(testSetOperationsFullOverflow<FT>(generator, N) > testSetOperationsFullOverflow<TwoChoiceFT>(generator, N));
+
+    cout << "Comparing insert failures under churn with the two choice filter" << endl;
+    FT pf(N);
+    TwoChoiceFT twoChoice(N);
+    assert(pf.sizeFilter() == twoChoice.sizeFilter());
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys(N*85/100);
+    for(size_t& key: keys) {
+        key = keyDist(generator) % pf.range;
+        assert(pf.insert(key));
+        assert(twoChoice.insert(key));
+    }
+    size_t failures = 0, twoChoiceFailures = 0;
+    for(size_t i{0}; i < 4*N; i++) {
+        size_t& key = keys[keyDist(generator) % keys.size()];
+        pf.remove(key);
+        twoChoice.remove(key);
+        key = keyDist(generator) % pf.range;
+        failures += !pf.insert(key);
+        twoChoiceFailures += !twoChoice.insert(key);
+    }
+    cout << "Failed inserts: " << failures << " against " << twoChoiceFailures << endl;
+    assert(failures <= twoChoiceFailures);
+    if(failures == 0) {
+        for(size_t key: keys) {
+            assert(pf.query(key));
+        }
+        sort(keys.begin(), keys.end());
+        assert(enumerateFilter(pf) == keys);
+    }
+}
+
+//Filters with a single region should behave exactly like the separate layout, and ones with several regions should hold the same keys in about the same space
+template<typename FT, typename SeparateFT>
+void testInterleavedLayout(mt19937 generator, size_t N, size_t largeN) {
+    cout << "Checking an interleaved filter spanning several regions" << endl;
+    FT pf(largeN);
+    SeparateFT separate(largeN);
+    cout << "Size " << pf.sizeFilter() << " against " << separate.sizeFilter() << endl;
+    assert(pf.sizeFilter() >= separate.sizeFilter() && pf.sizeFilter() < separate.sizeFilter() + (1ull << 21)/4); //The last region gets a whole backyard
+    assert(pf.range == separate.range);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    //Leaves out the keys of the frontyard buckets whose two backyard choices are the same bucket (see NEW_HASH), which the mapping within each region makes more common than in one large backyard. Without them, PQF_8_22 failed its first insert at 86% load at the earliest in either layout, against 82% with them
+    vector<size_t> keys(largeN*80/100);
+    for(size_t& key: keys) {
+        do {
+            key = keyDist(generator) % pf.range;
+        } while(!pf.backyardChoicesDistinct(key) || !separate.backyardChoicesDistinct(key));
+        assert(pf.insert(key));
+        assert(separate.insert(key));
+    }
+    for(size_t key: keys) {
+        assert(pf.query(key));
+    }
+    for(size_t i{0}; i < keys.size()/2; i++) {
+        assert(pf.remove(keys[i]));
+    }
+    keys.erase(keys.begin(), keys.begin() + keys.size()/2);
+    for(size_t key: keys) {
+        assert(pf.query(key));
+    }
+    FT copy(pf);
+    sort(keys.begin(), keys.end());
+    assert(enumerateFilter(copy) == keys);
+    pf.clear();
+    assert(enumerateFilter(pf).size() == 0);
+    assert(enumerateFilter(copy) == keys);
+}
+
+//128 byte frontyard buckets should send fewer keys to the backyard than 64 byte ones, in less space. Also goes through the batched operations, which prefetch both cachelines of a bucket
+template<typename FT, typename SmallFT>
+void testTwoCachelineBuckets(mt19937 generator, size_t N) {
+    cout << "Comparing backyard use with 64 byte buckets" << endl;
+    FT pf(N);
+    SmallFT small(N);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys(N*80/100), smallKeys(N*80/100);
+    for(size_t i{0}; i < keys.size(); i++) {
+        keys[i] = keyDist(generator) % pf.range;
+        smallKeys[i] = keyDist(generator) % small.range;
+    }
+    vector<bool> status(keys.size());
+    pf.insertBatch(keys, status, keys.size());
+    assert(all_of(status.begin(), status.end(), [](bool b) {return b;}));
+    size_t inBackyard = 0, smallInBackyard = 0;
+    for(size_t key: smallKeys) {
+        assert(small.insert(key));
+    }
+    for(size_t i{0}; i < keys.size(); i++) {
+        inBackyard += (pf.queryWhere(keys[i]) & 2) != 0;
+        smallInBackyard += (small.queryWhere(smallKeys[i]) & 2) != 0;
+    }
+    cout << "Keys in the backyard: " << inBackyard << " against " << smallInBackyard << ", size " << pf.sizeFilter() << " against " << small.sizeFilter() << endl;
+    assert(inBackyard < smallInBackyard && pf.sizeFilter() <= small.sizeFilter());
+    pf.queryBatch(keys, status, keys.size());
+    assert(all_of(status.begin(), status.end(), [](bool b) {return b;}));
+    pf.removeBatch(keys, status, keys.size()/2);
+    keys.erase(keys.begin(), keys.begin() + keys.size()/2);
+    sort(keys.begin(), keys.end());
+    assert(enumerateFilter(pf) == keys);
+}
+
+static size_t residentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t totalPages, residentPages;
+    statm >> totalPages >> residentPages;
+    return residentPages * 4096;
+}
+
+//Empty buckets are all zero bytes, so a huge filter should be built without touching its memory, and only use memory where keys land
+template<typename FT>
+void testZeroPageConstruction(mt19937 generator, size_t N) {
+    cout << "Checking that constructing a large filter does not touch its memory" << endl;
+    size_t residentBefore = residentBytes();
+    auto start = chrono::high_resolution_clock::now();
+    FT pf(N);
+    auto end = chrono::high_resolution_clock::now();
+    cout << "Constructed a filter of size " << pf.sizeFilter() << " in " << chrono::duration_cast<chrono::microseconds>(end-start).count() << "us" << endl;
+    assert(residentBytes() - residentBefore < pf.sizeFilter() / 8);
+
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys(1000);
+    for(size_t& key: keys) {
+        key = keyDist(generator) % pf.range;
+        assert(!pf.query(key) || find(keys.begin(), keys.end(), key) != keys.end());
+        assert(pf.insert(key));
+    }
+    for(size_t key: keys) {
+        assert(pf.query(key));
+    }
+    assert(residentBytes() - residentBefore < pf.sizeFilter() / 8);
+    pf.clear();
+    for(size_t key: keys) {
+        assert(!pf.query(key));
+    }
+}
+
+//Every thread tries to insert the same keys, so each distinct key should be reported as inserted exactly once
+template<typename FT>
+void testConcurrentInsertIfAbsent(mt19937 generator, size_t N, size_t numThreads) {
+    FT pf(N*1.2);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<size_t> keys(N);
+    for(size_t i{0}; i < N; i++) {
+        keys[i] = keyDist(generator) % pf.range;
+    }
+
+    cout << "Checking insertIfAbsent with " << numThreads << " threads" << endl;
+    vector<size_t> numInserted(numThreads, 0);
+    vector<thread> threads;
+    for(size_t t{0}; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for(size_t i{0}; i < N; i++) {
+                size_t key = keys[(i + t*N/numThreads) % N];
+                uint64_t status = pf.insertIfAbsent(key);
+                assert(status != 2);
+                numInserted[t] += status == 0;
+            }
+        });
+    }
+    for(auto& th: threads) {
+        th.join();
+    }
+    size_t totalInserted = 0;
+    for(size_t n: numInserted) {
+        totalInserted += n;
+    }
+    assert(totalInserted == set<size_t>(keys.begin(), keys.end()).size());
+}
+
+template<typename FT>
+void testTTL(mt19937 generator, size_t N, size_t ttl, size_t numEpochs) {
+    FT pf(N*1.2);
+    pf.setTTL(ttl);
+    constexpr size_t EpochMask = 7; //PQF_16_36_TTL stores three epoch bits in place of the low bits of the hash
+    size_t keysPerEpoch = N / (ttl+1);
+    uniform_int_distribution<size_t> keyDist(0, -1ull);
+    vector<vector<size_t>> keysByEpoch;
+
+    cout << "Checking expiry with a TTL of " << ttl << " epochs" << endl;
+    for(size_t epoch{0}; epoch < numEpochs; epoch++) {
+        assert(pf.getEpoch() == epoch);
+        keysByEpoch.emplace_back();
+        for(size_t i{0}; i < keysPerEpoch; i++) {
+            size_t key = keyDist(generator) % pf.range;
+            assert(pf.insert(key));
+            keysByEpoch.back().push_back(key);
+        }
+        if(epoch % 3 == 0) { //otherwise leave it to advanceEpoch and the lazy eviction on insert
+            pf.sweep(pf.getNumFrontyardBuckets() / 2);
+        }
+
+        set<size_t> liveFingerprints;
+        size_t numLive = 0;
+        for(size_t e = epoch+1 - min(epoch+1, ttl); e <= epoch; e++) {
+            for(size_t key: keysByEpoch[e]) {
+                assert(pf.query(key));
+                assert(pf.insertIfAbsent(key) == 1);
+                liveFingerprints.insert(key & ~EpochMask);
+                numLive++;
+            }
+        }
+        for(size_t e = 0; e + ttl <= epoch; e++) {
+            for(size_t key: keysByEpoch[e]) {
+                assert(pf.query(key) == liveFingerprints.contains(key & ~EpochMask));
+            }
+        }
+        if(epoch % 4 == 3) {
+            pf.sweep(pf.getNumFrontyardBuckets());
+            assert(enumerateFilter(pf).size() == numLive);
+        }
+        pf.advanceEpoch();
+    }
+
+    //Removing a live key removes only one copy, so remove everything still live and check the filter is empty
+    size_t lastEpoch = numEpochs - 1;
+    for(size_t e = numEpochs - min(numEpochs, ttl - 1); e <= lastEpoch; e++) {
+        for(size_t key: keysByEpoch[e]) {
+            assert(pf.remove(key));
+        }
+    }
+    pf.sweep(pf.getNumFrontyardBuckets());
+    assert(enumerateFilter(pf).size() == 0);
+}
+
 template<std::size_t RemainderSize, std::size_t BucketNumMiniBuckets, std::size_t FrontyardBucketCapacity, std::size_t BackyardBucketCapacity, std::size_t FrontyardToBackyardRatio, std::size_t FrontyardBucketSize, std::size_t BackyardBucketSize>
-void testDPF(mt19937 generator, size_t N) {
+void testDPF(mt19937 generator, size_t N, double slack = 1.2) {
     cout << "Testing DPF with params: " << BucketNumMiniBuckets << ", " << FrontyardBucketCapacity<< ", " << BackyardBucketCapacity << ", " << FrontyardToBackyardRatio << ", " << FrontyardBucketSize << " " << BackyardBucketSize << endl;
-    testFilter<PartitionQuotientFilter<RemainderSize, BucketNumMiniBuckets, FrontyardBucketCapacity, BackyardBucketCapacity, FrontyardToBackyardRatio, FrontyardBucketSize, BackyardBucketSize>>(generator, N);
+    using FT = PartitionQuotientFilter<RemainderSize, BucketNumMiniBuckets, FrontyardBucketCapacity, BackyardBucketCapacity, FrontyardToBackyardRatio, FrontyardBucketSize, BackyardBucketSize>;
+    testFilter<FT>(generator, N, slack);
+    testEnumeration<FT>(generator, N, slack);
+    testSetOperations<FT>(generator, N, slack);
+    testInsertIfAbsent<FT>(generator, N, slack);
 }
 
 template<std::size_t RemainderSize, std::size_t BucketNumMiniBuckets, std::size_t FrontyardBucketCapacity, std::size_t BackyardBucketCapacity, std::size_t FrontyardToBackyardRatio, std::size_t FrontyardBucketSize, std::size_t BackyardBucketSize>
@@ -161,6 +758,64 @@ int main(int argc, char* argv[]) {
     // testDPF<51, 51, 35, 8, 64, 64>(generator, N);
     testDPF<8, 22, 26, 18, 8, 32, 32>(generator, N);
     testDPF<16, 36, 28, 22, 8, 64, 64>(generator, N);
+    testDPF<5, 65, 63, 44, 8, 64, 64>(generator, N);
+    testDPF<6, 65, 63, 40, 8, 64, 64>(generator, N);
+    testDPF<7, 64, 56, 36, 8, 64, 64>(generator, N);
+    testDPF<10, 37, 43, 31, 8, 64, 64>(generator, N);
+    testDPF<12, 44, 36, 27, 8, 64, 64>(generator, N);
+    testDPF<20, 25, 23, 19, 6, 64, 64>(generator, N);
+    //Small buckets are planned for a lower load (see OptimalGeometry), so these get more room than the usual 1.2
+    testDPF<24, 12, 20, 16, 6, 64, 64>(generator, N, 1.3);
+    testDPF<32, 17, 15, 13, 5, 64, 64>(generator, N, 1.6);
+    //Ratios past 8, which take a 5 bit tag in the backyard
+    testDPF<8, 62, 50, 32, 12, 64, 64>(generator, N);
+    testDPF<8, 62, 50, 32, 16, 64, 64>(generator, N);
+    testDPF<16, 36, 28, 21, 12, 64, 64>(generator, N);
+    testDPF<8, 22, 26, 18, 4, 32, 32>(generator, N);
+    testTTL<PQF_16_36_TTL>(generator, N, 1, 10);
+    testTTL<PQF_16_36_TTL>(generator, N, 3, 20);
+    testTTL<PQF_16_36_TTL>(generator, N, 7, 30);
+    testKWayMerge<PQF_8_22>(generator, N, 8);
+    testKWayMerge<PQF_16_36>(generator, N, 2);
+    testKWayMerge<PQF_16_36>(generator, N, 4);
+    testUnequalMerge<PQF_8_22>(generator, N);
+    testUnequalMerge<PQF_16_36>(generator, N);
+    testLazyBackyard<PQF_8_22_LAZY, PQF_8_22>(generator, N);
+    testLazyBackyard<PQF_16_36_LAZY, PQF_16_36>(generator, N);
+    testLazyBackyard<PQF_8_21_LAZY_T, PQF_8_21_T>(generator, N);
+    testZeroPageConstruction<PQF_8_22>(generator, 1ull << 30);
+    testZeroPageConstruction<PQF_16_36>(generator, 1ull << 28);
+    testConcurrentInsertIfAbsent<PQF_8_21_T>(generator, N, 4);
+    testConcurrentInsertIfAbsent<PQF_8_21_LAZY_T>(generator, N, 4);
+    testConcurrentInsertIfAbsent<PQF_16_35_T>(generator, N, 4);
+    testAllOperations<PQF_8_22_2C>(generator, N);
+    testFrontyardSpill<PQF_8_22_2C, PQF_8_22>(generator, N);
+    testAllOperations<PQF_8_53_2C>(generator, N);
+    testFrontyardSpill<PQF_8_53_2C, PQF_8_53>(generator, N);
+    testAllOperations<PQF_16_36_2C>(generator, N);
+    testFrontyardSpill<PQF_16_36_2C, PQF_16_36>(generator, N);
+    testConcurrentInsertIfAbsent<PartitionQuotientFilter<8, 21, 26, 18, 8, 32, 32, false, true, 0, false, SelectType::Pdep, FrontyardSpill::Partner>>(generator, N, 4);
+    testAllOperations<PQF_8_22_SIB>(generator, N);
+    testFrontyardSpill<PQF_8_22_SIB, PQF_8_22>(generator, N);
+    testConcurrentInsertIfAbsent<PQF_8_21_SIB_T>(generator, N, 4);
+    testAllOperations<PQF_8_22_D3>(generator, N);
+    testBackyardChoices<PQF_8_22_D3, PQF_8_22>(generator, N);
+    testAllOperations<PQF_8_22_D4>(generator, N);
+    testBackyardChoices<PQF_8_22_D4, PQF_8_22>(generator, N);
+    testAllOperations<PQF_16_36_D4>(generator, N);
+    testBackyardChoices<PQF_16_36_D4, PQF_16_36>(generator, N);
+    testConcurrentInsertIfAbsent<PQF_8_21_D4_T>(generator, N, 4);
+    testAllOperations<PQF_8_22_IL>(generator, N);
+    testInterleavedLayout<PQF_8_22_IL, PQF_8_22>(generator, N, 1ull << 23);
+    testAllOperations<PQF_16_36_IL>(generator, N);
+    testInterleavedLayout<PQF_16_36_IL, PQF_16_36>(generator, N, 1ull << 23);
+    testConcurrentInsertIfAbsent<PQF_8_21_IL_T>(generator, N, 4);
+    testConcurrentInsertIfAbsent<PQF_8_21_IL_T>(generator, 1ull << 22, 4);
+    testAllOperations<PQF_16_55_128>(generator, N);
+    testTwoCachelineBuckets<PQF_16_55_128, PQF_16_36>(generator, N);
+    testAllOperations<PQF_16_55_128_FRQ>(generator, N);
+    testTwoCachelineBuckets<PQF_16_55_128_FRQ, PQF_16_36>(generator, N);
+    testConcurrentInsertIfAbsent<PQF_16_54_128_T>(generator, N, 4);
     // testDPF<25, 25, 17, 4, 32, 32>(generator, N);
     // testDPF<25, 25, 17, 4, 32, 32>(generator, N);
     // testDPF<25, 25, 17, 8, 32, 32>(generator, N);
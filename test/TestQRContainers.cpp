@@ -12,9 +12,10 @@ void testQRContainers (mt19937& generator){
     using FrontyardQRType = FrontyardQRContainer<NumMiniBuckets>;
     using BackyardQRType = BackyardQRContainer<NumMiniBuckets, RemainderBits, ConsolidationFactor>;
     constexpr size_t cfactor = ConsolidationFactor;
+    constexpr size_t R = 10000000000ull;
 
     //We are "building up" the quotient from the backyard and stuff
-    uniform_int_distribution<size_t> backBucketIndexDist(1000, 10000000000ull);
+    uniform_int_distribution<size_t> backBucketIndexDist(1000, R-1);
     size_t backBucketIndex = backBucketIndexDist(generator);
     uniform_int_distribution<size_t> miniBucketIndexDist(0, NumMiniBuckets-1);
     size_t miniBucketIndex = miniBucketIndexDist(generator);
@@ -27,7 +28,7 @@ void testQRContainers (mt19937& generator){
     uniform_int_distribution<size_t> remainderDist(0, (1ull << RemainderBits)-1);
     size_t remainder = remainderDist(generator);
 
-    size_t firstBackBucketIndex = secondFrontyardBucket *(10000000000ull / cfactor /cfactor) + backBucketIndex;
+    size_t firstBackBucketIndex = secondFrontyardBucket*R + backBucketIndex;
     size_t firstBackBucketRemainder = (firstFrontyardBucket << RemainderBits) + remainder;
 
     size_t secondBackBucketIndex = backBucketIndex*cfactor + firstFrontyardBucket;
@@ -40,21 +41,21 @@ void testQRContainers (mt19937& generator){
     // assert(fqr.quotient == quotient); //these here seem overly ridiculous but whatever
     assert(fqr.remainder == remainder);
 
-    BackyardQRType bqr1(quotient, remainder, false, 10000000000ull);
+    BackyardQRType bqr1(quotient, remainder, false, R);
     assert(bqr1.bucketIndex == firstBackBucketIndex);
     assert(bqr1.miniBucketIndex == miniBucketIndex);
     // assert(bqr1.quotient == quotient);
     assert(bqr1.realRemainder == remainder);
     assert(bqr1.remainder == firstBackBucketRemainder);
 
-    bqr1 = BackyardQRType(fqr, false, 10000000000ull);
+    bqr1 = BackyardQRType(fqr, false, R);
     assert(bqr1.bucketIndex == firstBackBucketIndex);
     assert(bqr1.miniBucketIndex == miniBucketIndex);
     // assert(bqr1.quotient == quotient);
     assert(bqr1.realRemainder == remainder);
     assert(bqr1.remainder == firstBackBucketRemainder);
 
-    BackyardQRType bqr2(quotient, remainder, true, 10000000000ull);
+    BackyardQRType bqr2(quotient, remainder, true, R);
     assert(bqr2.bucketIndex == secondBackBucketIndex);
     assert(bqr2.miniBucketIndex == miniBucketIndex);
     // assert(bqr2.quotient == quotient);
@@ -63,7 +64,7 @@ void testQRContainers (mt19937& generator){
     assert(bqr2.remainder == secondBackBucketRemainder + (1ull << RemainderBits) * 8);
     assert(bqr2.remainder < 4096);
 
-    bqr2 = BackyardQRType(fqr, true, 10000000000ull);
+    bqr2 = BackyardQRType(fqr, true, R);
     assert(bqr2.bucketIndex == secondBackBucketIndex);
     assert(bqr2.miniBucketIndex == miniBucketIndex);
     // assert(bqr2.quotient == quotient);
@@ -73,6 +74,31 @@ void testQRContainers (mt19937& generator){
 
 }
 
+//The third and fourth backyard choices are the first two half the backyard along, with the top tag bit set
+template<std::size_t NumMiniBuckets, size_t ConsolidationFactor>
+void testMovedChoices(mt19937& generator) {
+    constexpr size_t RemainderBits = 8;
+    using BackyardQRType = BackyardQRContainer<NumMiniBuckets, RemainderBits, ConsolidationFactor, 4>;
+    static_assert(BackyardQRType::TagBits == BackyardQRContainer<NumMiniBuckets, RemainderBits, ConsolidationFactor>::TagBits + 1);
+    constexpr size_t R = 10000000000ull;
+    size_t backyardSize = R*ConsolidationFactor + 7;
+    uniform_int_distribution<size_t> quotientDist(0, R*ConsolidationFactor*ConsolidationFactor*NumMiniBuckets - 1);
+    uniform_int_distribution<size_t> remainderDist(0, (1ull << RemainderBits)-1);
+    FrontyardQRContainer<NumMiniBuckets> fqr(quotientDist(generator), remainderDist(generator));
+
+    for(bool hashNum: {false, true}) {
+        BackyardQRType bqr(fqr, hashNum, R);
+        BackyardQRType moved = bqr;
+        moved.moveToUpperHalf(backyardSize);
+        assert(moved.bucketIndex == (bqr.bucketIndex + backyardSize/2) % backyardSize);
+        assert(moved.miniBucketIndex == bqr.miniBucketIndex);
+        assert(moved.whichFrontyardBucket == bqr.whichFrontyardBucket + 2*BackyardQRType::ConsolidationFactorP2);
+        assert(moved.remainder >> RemainderBits == moved.whichFrontyardBucket);
+        assert(moved.whichFrontyardBucket < (1ull << BackyardQRType::TagBits));
+        assert((moved.remainder & ((1ull << RemainderBits) - 1)) == fqr.remainder);
+    }
+}
+
 int main() {
     random_device rd;
     mt19937 generator (rd());
@@ -84,5 +110,8 @@ int main() {
         testQRContainers<26, 1, 8>(generator);
         testQRContainers<47, 0, 8>(generator);
         testQRContainers<47, 1, 8>(generator);
+        testMovedChoices<26, 8>(generator);
+        testMovedChoices<52, 7>(generator);
+        testMovedChoices<47, 16>(generator);
     }
 }
\ No newline at end of file
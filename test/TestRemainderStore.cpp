@@ -5,15 +5,16 @@
 #include <set>
 #include <map>
 #include <optional>
+#include <functional>
 #include "RemainderStore.hpp"
 
 using namespace std;
 using namespace PQF;
 
-template<size_t SizeRemainder, size_t NumKeys, template<size_t, std::size_t, std::size_t> class StoreType>
-struct alignas(64) FakeBucket {
-    static constexpr size_t frontOffsetSize = (64-StoreType<SizeRemainder, NumKeys, 0>::Size)/2;
-    static constexpr size_t backOffsetSize = 64-StoreType<SizeRemainder, NumKeys, 0>::Size-frontOffsetSize;
+template<size_t SizeRemainder, size_t NumKeys, template<size_t, std::size_t, std::size_t> class StoreType, size_t BucketSize = 64>
+struct alignas(BucketSize) FakeBucket {
+    static constexpr size_t frontOffsetSize = (BucketSize-StoreType<SizeRemainder, NumKeys, 0>::Size)/2;
+    static constexpr size_t backOffsetSize = BucketSize-StoreType<SizeRemainder, NumKeys, 0>::Size-frontOffsetSize;
     
     std::array<uint8_t, frontOffsetSize> frontOffset;
     StoreType<SizeRemainder, NumKeys, frontOffsetSize> remainderStore;
@@ -28,7 +29,7 @@ struct alignas(64) FakeBucket {
     }
 
     FakeBucket(mt19937 generator) {
-        assert(sizeof(*this) == 64);
+        assert(sizeof(*this) == BucketSize);
 
         uniform_int_distribution<uint8_t> uint8_dist(0, 255);
         for(uint8_t& byte: frontOffset) {
@@ -70,11 +71,11 @@ struct alignas(64) FakeBucket {
     }
 };
 
-template<std::size_t SizeRemainder, size_t NumKeys, size_t NumMiniBuckets, template<std::size_t, std::size_t, std::size_t> class StoreType, size_t StoreTypeRemainderSize>
+template<std::size_t SizeRemainder, size_t NumKeys, size_t NumMiniBuckets, template<std::size_t, std::size_t, std::size_t> class StoreType, size_t StoreTypeRemainderSize, size_t BucketSize = 64>
 void testBucket(mt19937& generator) {
     cout << "Testing with " << NumKeys << " keys." << endl;
 
-    FakeBucket<SizeRemainder, NumKeys, StoreType> testBucket(generator);
+    FakeBucket<SizeRemainder, NumKeys, StoreType, BucketSize> testBucket(generator);
     array<size_t, NumMiniBuckets> sizeEachMiniBucket{};
     // map<pair<size_t, uint64_t>, uint64_t> remToExpectedMask;
     set<pair<pair<size_t, size_t>, uint64_t>> remaindersForUnordered;
@@ -172,6 +173,32 @@ int main() {
         testBucket<16, 24, 24, RemainderStore, 16>(generator);
         cout << "Testing 20 bit" << endl;
         testBucket<20, 16, 16, RemainderStore, 20>(generator);
+        //Packed widths, which do not start on byte boundaries
+        cout << "Testing 5 bit" << endl;
+        testBucket<5, 63, 65, RemainderStore, 5>(generator);
+        cout << "Testing 6 bit" << endl;
+        testBucket<6, 50, 40, RemainderStore, 6>(generator);
+        cout << "Testing 7 bit" << endl;
+        testBucket<7, 56, 64, RemainderStore, 7>(generator);
+        cout << "Testing 10 bit" << endl;
+        testBucket<10, 43, 37, RemainderStore, 10>(generator);
+        cout << "Testing 12 bit, few keys" << endl;
+        testBucket<12, 9, 5, RemainderStore, 12>(generator);
+        cout << "Testing 24 bit" << endl;
+        testBucket<24, 20, 12, RemainderStore, 24>(generator);
+        cout << "Testing 32 bit" << endl;
+        testBucket<32, 15, 17, RemainderStore, 32>(generator);
+        //Stores that straddle the middle of the bucket, which the AVX2 versions have to shift across the two 256 bit halves
+        cout << "Testing 4 bit across halves" << endl;
+        testBucket<4, 41, 30, RemainderStore, 4>(generator);
+        cout << "Testing 8 bit across halves" << endl;
+        testBucket<8, 20, 16, RemainderStore, 8>(generator);
+        cout << "Testing 16 bit across halves" << endl;
+        testBucket<16, 30, 20, RemainderStore, 16>(generator);
+        //128 byte buckets, where the store spans both cachelines
+        cout << "Testing 16 bit across cachelines" << endl;
+        testBucket<16, 54, 106, RemainderStore, 16, 128>(generator);
+        testBucket<16, 62, 20, RemainderStore, 16, 128>(generator);
     }
     // cout << "Testing 12 bit (composite of 4 & 8)" << endl;
     // for(size_t i{0}; i < 100; i++) {
@@ -415,6 +415,63 @@ using PQF_16_36_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36, PQF_16_36_Wrapper_
 static const char PQF_16_36_FRQ_Wrapper_str[] = "PQF_16_36_FRQ";
 using PQF_16_36_FRQ_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_FRQ, PQF_16_36_FRQ_Wrapper_str>;
 
+static const char PQF_5_65_Wrapper_str[] = "PQF_5_65";
+using PQF_5_65_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_5_65, PQF_5_65_Wrapper_str>;
+static const char PQF_6_65_Wrapper_str[] = "PQF_6_65";
+using PQF_6_65_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_6_65, PQF_6_65_Wrapper_str>;
+static const char PQF_7_64_Wrapper_str[] = "PQF_7_64";
+using PQF_7_64_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_7_64, PQF_7_64_Wrapper_str>;
+static const char PQF_10_37_Wrapper_str[] = "PQF_10_37";
+using PQF_10_37_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_10_37, PQF_10_37_Wrapper_str>;
+static const char PQF_12_44_Wrapper_str[] = "PQF_12_44";
+using PQF_12_44_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_12_44, PQF_12_44_Wrapper_str>;
+static const char PQF_20_25_Wrapper_str[] = "PQF_20_25";
+using PQF_20_25_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_20_25, PQF_20_25_Wrapper_str>;
+static const char PQF_24_12_Wrapper_str[] = "PQF_24_12";
+using PQF_24_12_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_24_12, PQF_24_12_Wrapper_str>;
+static const char PQF_32_17_Wrapper_str[] = "PQF_32_17";
+using PQF_32_17_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_32_17, PQF_32_17_Wrapper_str>;
+
+static const char PQF_8_22_LAZY_Wrapper_str[] = "PQF_8_22_LAZY";
+using PQF_8_22_LAZY_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_LAZY, PQF_8_22_LAZY_Wrapper_str>;
+static const char PQF_16_36_LAZY_Wrapper_str[] = "PQF_16_36_LAZY";
+using PQF_16_36_LAZY_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_LAZY, PQF_16_36_LAZY_Wrapper_str>;
+
+static const char PQF_8_22_BWS_Wrapper_str[] = "PQF_8_22_BWS";
+using PQF_8_22_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_BWS, PQF_8_22_BWS_Wrapper_str>;
+static const char PQF_8_53_BWS_Wrapper_str[] = "PQF_8_53_BWS";
+using PQF_8_53_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_53_BWS, PQF_8_53_BWS_Wrapper_str>;
+static const char PQF_16_36_BWS_Wrapper_str[] = "PQF_16_36_BWS";
+using PQF_16_36_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_BWS, PQF_16_36_BWS_Wrapper_str>;
+
+static const char PQF_8_22_2C_Wrapper_str[] = "PQF_8_22_2C";
+using PQF_8_22_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_2C, PQF_8_22_2C_Wrapper_str>;
+static const char PQF_8_53_2C_Wrapper_str[] = "PQF_8_53_2C";
+using PQF_8_53_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_53_2C, PQF_8_53_2C_Wrapper_str>;
+static const char PQF_16_36_2C_Wrapper_str[] = "PQF_16_36_2C";
+using PQF_16_36_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_2C, PQF_16_36_2C_Wrapper_str>;
+
+static const char PQF_8_22_SIB_Wrapper_str[] = "PQF_8_22_SIB";
+using PQF_8_22_SIB_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_SIB, PQF_8_22_SIB_Wrapper_str>;
+static const char PQF_8_22BB_SIB_Wrapper_str[] = "PQF_8_22BB_SIB";
+using PQF_8_22BB_SIB_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22BB_SIB, PQF_8_22BB_SIB_Wrapper_str>;
+
+static const char PQF_8_22_D3_Wrapper_str[] = "PQF_8_22_D3";
+using PQF_8_22_D3_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_D3, PQF_8_22_D3_Wrapper_str>;
+static const char PQF_8_22_D4_Wrapper_str[] = "PQF_8_22_D4";
+using PQF_8_22_D4_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_D4, PQF_8_22_D4_Wrapper_str>;
+static const char PQF_16_36_D4_Wrapper_str[] = "PQF_16_36_D4";
+using PQF_16_36_D4_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_D4, PQF_16_36_D4_Wrapper_str>;
+static const char PQF_8_22_IL_Wrapper_str[] = "PQF_8_22_IL";
+using PQF_8_22_IL_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_IL, PQF_8_22_IL_Wrapper_str>;
+static const char PQF_16_36_IL_Wrapper_str[] = "PQF_16_36_IL";
+using PQF_16_36_IL_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_IL, PQF_16_36_IL_Wrapper_str>;
+
+static const char PQF_16_55_128_Wrapper_str[] = "PQF_16_55_128";
+using PQF_16_55_128_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_55_128, PQF_16_55_128_Wrapper_str>;
+static const char PQF_16_55_128_FRQ_Wrapper_str[] = "PQF_16_55_128_FRQ";
+using PQF_16_55_128_FRQ_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_55_128_FRQ, PQF_16_55_128_FRQ_Wrapper_str>;
+
 #else
 static const char PQF_8_22_Wrapper_str[] = "PQF_8_22_AVX2";
 using PQF_8_22_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22, PQF_8_22_Wrapper_str>;
@@ -446,6 +503,63 @@ static const char PQF_16_36_Wrapper_str[] = "PQF_16_36_AVX2";
 using PQF_16_36_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36, PQF_16_36_Wrapper_str>;
 static const char PQF_16_36_FRQ_Wrapper_str[] = "PQF_16_36_FRQ_AVX2";
 using PQF_16_36_FRQ_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_FRQ, PQF_16_36_FRQ_Wrapper_str>;
+
+static const char PQF_5_65_Wrapper_str[] = "PQF_5_65_AVX2";
+using PQF_5_65_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_5_65, PQF_5_65_Wrapper_str>;
+static const char PQF_6_65_Wrapper_str[] = "PQF_6_65_AVX2";
+using PQF_6_65_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_6_65, PQF_6_65_Wrapper_str>;
+static const char PQF_7_64_Wrapper_str[] = "PQF_7_64_AVX2";
+using PQF_7_64_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_7_64, PQF_7_64_Wrapper_str>;
+static const char PQF_10_37_Wrapper_str[] = "PQF_10_37_AVX2";
+using PQF_10_37_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_10_37, PQF_10_37_Wrapper_str>;
+static const char PQF_12_44_Wrapper_str[] = "PQF_12_44_AVX2";
+using PQF_12_44_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_12_44, PQF_12_44_Wrapper_str>;
+static const char PQF_20_25_Wrapper_str[] = "PQF_20_25_AVX2";
+using PQF_20_25_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_20_25, PQF_20_25_Wrapper_str>;
+static const char PQF_24_12_Wrapper_str[] = "PQF_24_12_AVX2";
+using PQF_24_12_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_24_12, PQF_24_12_Wrapper_str>;
+static const char PQF_32_17_Wrapper_str[] = "PQF_32_17_AVX2";
+using PQF_32_17_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_32_17, PQF_32_17_Wrapper_str>;
+
+static const char PQF_8_22_LAZY_Wrapper_str[] = "PQF_8_22_LAZY_AVX2";
+using PQF_8_22_LAZY_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_LAZY, PQF_8_22_LAZY_Wrapper_str>;
+static const char PQF_16_36_LAZY_Wrapper_str[] = "PQF_16_36_LAZY_AVX2";
+using PQF_16_36_LAZY_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_LAZY, PQF_16_36_LAZY_Wrapper_str>;
+
+static const char PQF_8_22_BWS_Wrapper_str[] = "PQF_8_22_BWS_AVX2";
+using PQF_8_22_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_BWS, PQF_8_22_BWS_Wrapper_str>;
+static const char PQF_8_53_BWS_Wrapper_str[] = "PQF_8_53_BWS_AVX2";
+using PQF_8_53_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_53_BWS, PQF_8_53_BWS_Wrapper_str>;
+static const char PQF_16_36_BWS_Wrapper_str[] = "PQF_16_36_BWS_AVX2";
+using PQF_16_36_BWS_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_BWS, PQF_16_36_BWS_Wrapper_str>;
+
+static const char PQF_8_22_2C_Wrapper_str[] = "PQF_8_22_2C_AVX2";
+using PQF_8_22_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_2C, PQF_8_22_2C_Wrapper_str>;
+static const char PQF_8_53_2C_Wrapper_str[] = "PQF_8_53_2C_AVX2";
+using PQF_8_53_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_53_2C, PQF_8_53_2C_Wrapper_str>;
+static const char PQF_16_36_2C_Wrapper_str[] = "PQF_16_36_2C_AVX2";
+using PQF_16_36_2C_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_2C, PQF_16_36_2C_Wrapper_str>;
+
+static const char PQF_8_22_SIB_Wrapper_str[] = "PQF_8_22_SIB_AVX2";
+using PQF_8_22_SIB_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_SIB, PQF_8_22_SIB_Wrapper_str>;
+static const char PQF_8_22BB_SIB_Wrapper_str[] = "PQF_8_22BB_SIB_AVX2";
+using PQF_8_22BB_SIB_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22BB_SIB, PQF_8_22BB_SIB_Wrapper_str>;
+
+static const char PQF_8_22_D3_Wrapper_str[] = "PQF_8_22_D3_AVX2";
+using PQF_8_22_D3_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_D3, PQF_8_22_D3_Wrapper_str>;
+static const char PQF_8_22_D4_Wrapper_str[] = "PQF_8_22_D4_AVX2";
+using PQF_8_22_D4_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_D4, PQF_8_22_D4_Wrapper_str>;
+static const char PQF_16_36_D4_Wrapper_str[] = "PQF_16_36_D4_AVX2";
+using PQF_16_36_D4_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_D4, PQF_16_36_D4_Wrapper_str>;
+static const char PQF_8_22_IL_Wrapper_str[] = "PQF_8_22_IL_AVX2";
+using PQF_8_22_IL_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_8_22_IL, PQF_8_22_IL_Wrapper_str>;
+static const char PQF_16_36_IL_Wrapper_str[] = "PQF_16_36_IL_AVX2";
+using PQF_16_36_IL_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_36_IL, PQF_16_36_IL_Wrapper_str>;
+
+static const char PQF_16_55_128_Wrapper_str[] = "PQF_16_55_128_AVX2";
+using PQF_16_55_128_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_55_128, PQF_16_55_128_Wrapper_str>;
+static const char PQF_16_55_128_FRQ_Wrapper_str[] = "PQF_16_55_128_FRQ_AVX2";
+using PQF_16_55_128_FRQ_Wrapper = PQF_Wrapper_SingleT<PQF::PQF_16_55_128_FRQ, PQF_16_55_128_FRQ_Wrapper_str>;
 #endif
 
 
@@ -476,6 +590,17 @@ using PQF_16_35_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_35_T, PQF_16_35_T_Wra
 static const char PQF_16_35_FRQ_T_Wrapper_str[] = "PQF_16_35_FRQ_T";
 using PQF_16_35_FRQ_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_35_FRQ_T, PQF_16_35_FRQ_T_Wrapper_str>;
 
+static const char PQF_8_21_SIB_T_Wrapper_str[] = "PQF_8_21_SIB_T";
+using PQF_8_21_SIB_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_SIB_T, PQF_8_21_SIB_T_Wrapper_str>;
+
+static const char PQF_8_21_D4_T_Wrapper_str[] = "PQF_8_21_D4_T";
+using PQF_8_21_D4_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_D4_T, PQF_8_21_D4_T_Wrapper_str>;
+static const char PQF_8_21_IL_T_Wrapper_str[] = "PQF_8_21_IL_T";
+using PQF_8_21_IL_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_IL_T, PQF_8_21_IL_T_Wrapper_str>;
+
+static const char PQF_16_54_128_T_Wrapper_str[] = "PQF_16_54_128_T";
+using PQF_16_54_128_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_54_128_T, PQF_16_54_128_T_Wrapper_str>;
+
 #else
 
 static const char PQF_8_21_T_Wrapper_str[] = "PQF_8_21_T_AVX2";
@@ -493,6 +618,17 @@ using PQF_16_35_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_35_T, PQF_16_35_T_Wra
 static const char PQF_16_35_FRQ_T_Wrapper_str[] = "PQF_16_35_FRQ_T_AVX2";
 using PQF_16_35_FRQ_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_35_FRQ_T, PQF_16_35_FRQ_T_Wrapper_str>;
 
+static const char PQF_8_21_SIB_T_Wrapper_str[] = "PQF_8_21_SIB_T_AVX2";
+using PQF_8_21_SIB_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_SIB_T, PQF_8_21_SIB_T_Wrapper_str>;
+
+static const char PQF_8_21_D4_T_Wrapper_str[] = "PQF_8_21_D4_T_AVX2";
+using PQF_8_21_D4_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_D4_T, PQF_8_21_D4_T_Wrapper_str>;
+static const char PQF_8_21_IL_T_Wrapper_str[] = "PQF_8_21_IL_T_AVX2";
+using PQF_8_21_IL_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_8_21_IL_T, PQF_8_21_IL_T_Wrapper_str>;
+
+static const char PQF_16_54_128_T_Wrapper_str[] = "PQF_16_54_128_T_AVX2";
+using PQF_16_54_128_T_Wrapper = PQF_Wrapper_MultiT<PQF::PQF_16_54_128_T, PQF_16_54_128_T_Wrapper_str>;
+
 #endif
 
 
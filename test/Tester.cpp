@@ -1090,6 +1090,24 @@ private:
     inline static const std::set <std::string> settingTypes = Settings::SettingTypes();
     inline static const std::set <std::string> FTNames{std::string{FTWrappers::name}...};
     inline static const std::set <std::string> TestNames{std::string{TestWrappers::name}...};
+
+    //The names the same filters have in the build for the other instruction set (the AVX2 build suffixes them with _AVX2).
+    //These are skipped rather than rejected, so that one config can list both and be run by both Testers on the same machine to compare them.
+    static std::set <std::string> otherISAFTNames() {
+        static constexpr std::string_view suffix = "_AVX2";
+        std::set <std::string> names;
+        for (const std::string &name: FTNames) {
+            if (name.ends_with(suffix)) {
+                names.insert(name.substr(0, name.size() - suffix.size()));
+            } else {
+                names.insert(name + std::string{suffix});
+            }
+        }
+        for (const std::string &name: FTNames) {
+            names.erase(name);
+        }
+        return names;
+    }
 public:
     static void
     runTests(const char *configFilepath, const char *outputFilepath, const char *analysisFolderPath = nullptr,
@@ -1101,6 +1119,8 @@ public:
         keywords.insert(FTNames.begin(), FTNames.end());
         keywords.insert(TestNames.begin(), TestNames.end());
         keywords.insert(settingTypes.begin(), settingTypes.end());
+        const std::set <std::string> otherISANames = otherISAFTNames();
+        keywords.insert(otherISANames.begin(), otherISANames.end());
 
         auto config = readConfig(configFilepath, keywords);
 
@@ -1121,6 +1141,8 @@ public:
                         // std::cout << setting << std::endl;
                         testsToRun.insert(setting);
                     }
+                } else if (otherISANames.count(keyword) == 1) {
+                    continue;
                 } else {
                     std::cerr << "Bug in the code" << std::endl;
                     exit(-1);
@@ -1212,6 +1234,15 @@ public:
 using FTTuple = std::tuple<PQF_8_22_Wrapper, PQF_8_22_FRQ_Wrapper, PQF_8_22BB_Wrapper, PQF_8_22BB_FRQ_Wrapper,
         PQF_8_31_Wrapper, PQF_8_31_FRQ_Wrapper, PQF_8_62_Wrapper, PQF_8_62_FRQ_Wrapper,
         PQF_8_53_Wrapper, PQF_8_53_FRQ_Wrapper, PQF_16_36_Wrapper, PQF_16_36_FRQ_Wrapper,
+        PQF_5_65_Wrapper, PQF_6_65_Wrapper, PQF_7_64_Wrapper, PQF_10_37_Wrapper,
+        PQF_12_44_Wrapper, PQF_20_25_Wrapper, PQF_24_12_Wrapper, PQF_32_17_Wrapper,
+        PQF_8_22_LAZY_Wrapper, PQF_16_36_LAZY_Wrapper,
+        PQF_8_22_BWS_Wrapper, PQF_8_53_BWS_Wrapper, PQF_16_36_BWS_Wrapper,
+        PQF_8_22_2C_Wrapper, PQF_8_53_2C_Wrapper, PQF_16_36_2C_Wrapper,
+        PQF_8_22_SIB_Wrapper, PQF_8_22BB_SIB_Wrapper, PQF_8_21_SIB_T_Wrapper,
+        PQF_8_22_D3_Wrapper, PQF_8_22_D4_Wrapper, PQF_16_36_D4_Wrapper, PQF_8_21_D4_T_Wrapper,
+        PQF_8_22_IL_Wrapper, PQF_16_36_IL_Wrapper, PQF_8_21_IL_T_Wrapper,
+        PQF_16_55_128_Wrapper, PQF_16_55_128_FRQ_Wrapper, PQF_16_54_128_T_Wrapper,
         PQF_8_21_T_Wrapper, PQF_8_21_FRQ_T_Wrapper, PQF_8_52_T_Wrapper, PQF_8_52_FRQ_T_Wrapper,
         PQF_16_35_T_Wrapper, PQF_16_35_FRQ_T_Wrapper,
         PF_TC_Wrapper,
@@ -1225,6 +1256,15 @@ using FTTuple = std::tuple<PQF_8_22_Wrapper, PQF_8_22_FRQ_Wrapper, PQF_8_22BB_Wr
 using FTTuple = std::tuple<PQF_8_22_Wrapper, PQF_8_22_FRQ_Wrapper, PQF_8_22BB_Wrapper, PQF_8_22BB_FRQ_Wrapper,
         PQF_8_31_Wrapper, PQF_8_31_FRQ_Wrapper, PQF_8_62_Wrapper, PQF_8_62_FRQ_Wrapper,
         PQF_8_53_Wrapper, PQF_8_53_FRQ_Wrapper, PQF_16_36_Wrapper, PQF_16_36_FRQ_Wrapper,
+        PQF_5_65_Wrapper, PQF_6_65_Wrapper, PQF_7_64_Wrapper, PQF_10_37_Wrapper,
+        PQF_12_44_Wrapper, PQF_20_25_Wrapper, PQF_24_12_Wrapper, PQF_32_17_Wrapper,
+        PQF_8_22_LAZY_Wrapper, PQF_16_36_LAZY_Wrapper,
+        PQF_8_22_BWS_Wrapper, PQF_8_53_BWS_Wrapper, PQF_16_36_BWS_Wrapper,
+        PQF_8_22_2C_Wrapper, PQF_8_53_2C_Wrapper, PQF_16_36_2C_Wrapper,
+        PQF_8_22_SIB_Wrapper, PQF_8_22BB_SIB_Wrapper, PQF_8_21_SIB_T_Wrapper,
+        PQF_8_22_D3_Wrapper, PQF_8_22_D4_Wrapper, PQF_16_36_D4_Wrapper, PQF_8_21_D4_T_Wrapper,
+        PQF_8_22_IL_Wrapper, PQF_16_36_IL_Wrapper, PQF_8_21_IL_T_Wrapper,
+        PQF_16_55_128_Wrapper, PQF_16_55_128_FRQ_Wrapper, PQF_16_54_128_T_Wrapper,
         PQF_8_21_T_Wrapper, PQF_8_21_FRQ_T_Wrapper, PQF_8_52_T_Wrapper, PQF_8_52_FRQ_T_Wrapper,
         PQF_16_35_T_Wrapper, PQF_16_35_FRQ_T_Wrapper,
         OriginalCF8_Wrapper, OriginalCF12_Wrapper, OriginalCF16_Wrapper,
@@ -1245,6 +1285,15 @@ using TestWrapperTuple = std::tuple<BenchmarkWrapper,
 using PQFTuple = std::tuple<PQF_8_22_Wrapper, PQF_8_22_FRQ_Wrapper, PQF_8_22BB_Wrapper, PQF_8_22BB_FRQ_Wrapper,
         PQF_8_31_Wrapper, PQF_8_31_FRQ_Wrapper, PQF_8_62_Wrapper, PQF_8_62_FRQ_Wrapper,
         PQF_8_53_Wrapper, PQF_8_53_FRQ_Wrapper, PQF_16_36_Wrapper, PQF_16_36_FRQ_Wrapper,
+        PQF_5_65_Wrapper, PQF_6_65_Wrapper, PQF_7_64_Wrapper, PQF_10_37_Wrapper,
+        PQF_12_44_Wrapper, PQF_20_25_Wrapper, PQF_24_12_Wrapper, PQF_32_17_Wrapper,
+        PQF_8_22_LAZY_Wrapper, PQF_16_36_LAZY_Wrapper,
+        PQF_8_22_BWS_Wrapper, PQF_8_53_BWS_Wrapper, PQF_16_36_BWS_Wrapper,
+        PQF_8_22_2C_Wrapper, PQF_8_53_2C_Wrapper, PQF_16_36_2C_Wrapper,
+        PQF_8_22_SIB_Wrapper, PQF_8_22BB_SIB_Wrapper, PQF_8_21_SIB_T_Wrapper,
+        PQF_8_22_D3_Wrapper, PQF_8_22_D4_Wrapper, PQF_16_36_D4_Wrapper, PQF_8_21_D4_T_Wrapper,
+        PQF_8_22_IL_Wrapper, PQF_16_36_IL_Wrapper, PQF_8_21_IL_T_Wrapper,
+        PQF_16_55_128_Wrapper, PQF_16_55_128_FRQ_Wrapper, PQF_16_54_128_T_Wrapper,
         PQF_8_21_T_Wrapper, PQF_8_21_FRQ_T_Wrapper, PQF_8_52_T_Wrapper, PQF_8_52_FRQ_T_Wrapper,
         PQF_16_35_T_Wrapper, PQF_16_35_FRQ_T_Wrapper, PQF_8_3_Wrapper,
         CQF_Wrapper>;